@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <lib/bst.hpp>
+
+// Zipf-distributed lookups: average comparisons per contains() stand in for the depth of the accessed node
+
+static size_t comparisons = 0;
+
+struct counting_less {
+  bool operator()(int lhs, int rhs) const {
+    ++comparisons;
+    return lhs < rhs;
+  }
+};
+
+template<class Balance>
+using tree = bst<int, int, Preorder, counting_less, std::allocator<std::pair<int, int>>, no_augment, Balance>;
+
+std::vector<int> zipf_keys(size_t key_count, size_t lookups, double exponent, std::mt19937& gen) {
+  std::vector<double> cdf(key_count);
+  double total = 0;
+  for (size_t i = 0; i < key_count; i++) {
+    total += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+    cdf[i] = total;
+  }
+  // hot ranks are scattered over the key space so the hot keys are not all in one subtree
+  std::vector<int> rank_to_key(key_count);
+  for (size_t i = 0; i < key_count; i++) rank_to_key[i] = static_cast<int>(i);
+  std::shuffle(rank_to_key.begin(), rank_to_key.end(), gen);
+
+  std::uniform_real_distribution<double> uniform(0, total);
+  std::vector<int> result(lookups);
+  for (auto& key : result) {
+    size_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(gen)) - cdf.begin();
+    key = rank_to_key[std::min(rank, key_count - 1)];
+  }
+  return result;
+}
+
+template<class Balance>
+void run(const char* name, const std::vector<int>& inserts, const std::vector<int>& lookups) {
+  tree<Balance> t;
+  for (int key : inserts) t.insert({key, key});
+
+  comparisons = 0;
+  size_t hits = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int key : lookups) hits += t.contains(key);
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << name << ": " << static_cast<double>(comparisons) / lookups.size() << " comparisons/lookup, "
+            << elapsed << " ms, " << hits << " hits" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  size_t key_count = argc > 1 ? std::stoul(argv[1]) : 100000;
+  size_t lookup_count = argc > 2 ? std::stoul(argv[2]) : 1000000;
+  double exponent = argc > 3 ? std::stod(argv[3]) : 1.0;
+
+  std::mt19937 gen(42);
+  std::vector<int> inserts(key_count);
+  for (size_t i = 0; i < key_count; i++) inserts[i] = static_cast<int>(i);
+  std::shuffle(inserts.begin(), inserts.end(), gen);
+  std::vector<int> lookups = zipf_keys(key_count, lookup_count, exponent, gen);
+
+  run<plain_tree>("plain_tree     ", inserts, lookups);
+  run<splay_tree>("splay_tree     ", inserts, lookups);
+  run<semi_splay_tree>("semi_splay_tree", inserts, lookups);
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Counters shared by a tracking_allocator, its copies and its rebinds, i.e. by one container.
+// Atomic because bst::clear_async frees nodes on another thread.
+struct allocation_stats {
+  std::atomic<size_t> live_bytes = 0;
+  std::atomic<size_t> peak_bytes = 0;
+  std::atomic<size_t> allocations = 0;
+  std::atomic<size_t> deallocations = 0;
+
+  size_t live_allocations() const noexcept { return allocations - deallocations; }
+};
+
+// Allocator adapter that forwards to Base and records what passes through it. A copy-constructed
+// container gets fresh counters through select_on_container_copy_construction.
+template<class T, class Base = std::allocator<T>>
+class tracking_allocator {
+ private:
+  using base_traits = std::allocator_traits<Base>;
+
+  Base base_;
+  std::shared_ptr<allocation_stats> stats_ = std::make_shared<allocation_stats>();
+
+  template<class U, class B>
+  friend class tracking_allocator;
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using propagate_on_container_move_assignment = std::true_type;
+
+  template<class U>
+  struct rebind {
+    using other = tracking_allocator<U, typename base_traits::template rebind_alloc<U>>;
+  };
+
+  tracking_allocator() = default;
+  explicit tracking_allocator(const Base& base) : base_(base) {}
+  template<class U, class B>
+  tracking_allocator(const tracking_allocator<U, B>& other) noexcept : base_(other.base_), stats_(other.stats_) {}
+
+  T* allocate(size_t n);
+  void deallocate(T* p, size_t n) noexcept;
+
+  tracking_allocator select_on_container_copy_construction() const {
+    return tracking_allocator(base_traits::select_on_container_copy_construction(base_));
+  }
+
+  const allocation_stats& stats() const noexcept { return *stats_; }
+
+  template<class U, class B>
+  bool operator==(const tracking_allocator<U, B>& other) const noexcept { return stats_ == other.stats_; }
+  template<class U, class B>
+  bool operator!=(const tracking_allocator<U, B>& other) const noexcept { return !(*this == other); }
+};
+
+template<class T, class Base>
+T* tracking_allocator<T, Base>::allocate(size_t n) {
+  T* p = base_traits::allocate(base_, n);
+  size_t live = stats_->live_bytes += n * sizeof(T);
+  size_t peak = stats_->peak_bytes;
+  while (peak < live && !stats_->peak_bytes.compare_exchange_weak(peak, live)) {}
+  ++stats_->allocations;
+  return p;
+}
+
+template<class T, class Base>
+void tracking_allocator<T, Base>::deallocate(T* p, size_t n) noexcept {
+  base_traits::deallocate(base_, p, n);
+  stats_->live_bytes -= n * sizeof(T);
+  ++stats_->deallocations;
+}
@@ -1,16 +1,40 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cinttypes>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include <lib/iterator/bst_generator.hpp>
 #include <lib/iterator/bst_iterator.hpp>
+#include <lib/policy/augment.hpp>
+#include <lib/policy/balance.hpp>
+#include <lib/policy/conflict.hpp>
+
+// default size hook for bst::memory_usage: elements own nothing beyond their node
+struct no_heap_size {
+  template<class T>
+  constexpr size_t operator()(const T&) const noexcept { return 0; }
+};
+
+// memory layout for bst::compact: recursive halving by height, so a root-to-leaf path
+// crosses O(log n / log B) blocks of B nodes
+struct VanEmdeBoas {};
 
 template<class Key, class Value, class Traversal = Preorder,
     class Compare = std::less<Key>,
-    class Alloc = std::allocator<std::pair<Key, Value>>>
+    class Alloc = std::allocator<std::pair<Key, Value>>,
+    class Augment = no_augment,
+    class Balance = plain_tree,
+    class Conflict = keep_min>
 class bst {
- private:
-  struct Node {
+ protected:
+  struct Node : augment_node<Augment> {
     std::pair<Key, Value> value;
 
     Node* left = nullptr;
@@ -31,24 +55,80 @@ class bst {
       return os;
     }
   };
-  size_t size_ = 0;
+  // Only changes are tracked while sized_ is false: split and join leave the element count
+  // unknown instead of walking the moved part, and size() recounts it on demand.
+  mutable size_t size_ = 0;
+  mutable bool sized_ = true;
 
   Node* root_ = nullptr;
   Node* last_ = nullptr;
+  Node* max_ = nullptr;  // cached maximum for hinted inserts, nullptr when unknown
 
-  void del_(Node* current);
+  size_t del_(Node* current);
   Node* insert_(Node* current, std::pair<Key, Value> value);
-  Node* extract_(Node* current, Key value);
-  Node* get_min_(Node* current);
-  Node* get_max_(Node* current);
-  Node* find_(Node* current, Key value);
+  template<class F>
+  Node* upsert_(Node* current, const Key& key, F& update);
+  static Node* get_min_(Node* current);
+  static Node* get_max_(Node* current);
+  Node* find_(Node* current, Key value) const;
   Node* copy(Node* other, Node* parent = nullptr);
+  // the node at the same position as node (a node of another tree of the same shape) below root
+  static Node* mirror_(Node* node, Node* root);
+
+  static constexpr bool multi_ = std::is_same_v<Conflict, keep_all>;
+  size_t count_equal_(Node* current, const Key& key) const;
+  Node* erase_equal_(Node* current, const Key& key);
+  Node* join_(Node* left, Node* right);
+  void detach_(Node* current);
+  void unlink_(Node* current);
+  static void split_(Node* current, const Key& key, Node*& left, Node*& right);
+  Node* erase_range_(Node* current, const Key& lo, const Key& hi, bool above_lo = false, bool below_hi = false);
+  static Node* next_inorder_(Node* current);
+  template<class Order>
+  static Node* first_(Node* current);
+  template<class Order>
+  static Node* next_(Node* current);
+  template<class Order, class Generator>
+  static Generator scan_(const bst* tree);
+  // runs[i] is [begin, end) of the run of keys equal to nodes[i]'s, only needed with keep_all
+  Node* build_(Node** nodes, const std::pair<size_t, size_t>* runs, size_t first, size_t last, Node* parent);
+  Node* finger_(Node* finger, const Key& key);
+
+  static constexpr bool augmented_ = !std::is_same_v<Augment, no_augment>;
+  static constexpr bool counted_ = std::is_same_v<Augment, count_of<typename Augment::value_type>>;
+  static Augment::value_type aggregate_(Node* current) requires augmented_;
+  static Augment::value_type lift_(Node* current) requires augmented_;
+  static void pull_(Node* current);
+
+  void rotate_(Node* current);
+  void splay_(Node* current);
  public:
   using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
   using allocator_traits = typename std::allocator_traits<allocator_type>;
 
   allocator_type allocator_;
 
+ protected:
+  // nodes placed by compact() share one allocation, given back once the last of them is freed
+  struct node_block {
+    Node* data = nullptr;
+    size_t capacity = 0;
+    size_t live = 0;
+  };
+  node_block block_;
+
+  static size_t release_(allocator_type& allocator, node_block& block, Node* current);
+  static bool owns_(const node_block& block, Node* current) {
+    return !std::less<Node*>{}(current, block.data) && std::less<Node*>{}(current, block.data + block.capacity);
+  }
+  static void free_(allocator_type& allocator, node_block& block, Node* current);
+  // moves a node out of a compact() block into its own allocation, keeping its links
+  Node* rehome_(Node* current, node_block& block);
+  void free_(Node* current) { free_(allocator_, block_, current); }
+  template<class Order>
+  void layout_(std::vector<Node*>& order) const;
+
+ public:
   using iterator = bst_iterator<Node, Traversal>;
   using const_iterator = const iterator;
   using reverse_iterator = std::reverse_iterator<iterator>;
@@ -58,7 +138,9 @@ class bst {
   using mapped_type = Value;
   using key_compare = Compare;
   using size_type = std::size_t;
-  using node_type = Node;
+  using aggregate_type = Augment::value_type;
+  class node_handle;
+  using node_type = node_handle;
 
   using value_type = std::pair<Key, Value>;
   using reference = value_type&;
@@ -68,14 +150,45 @@ class bst {
 
   using difference_type = iterator::difference_type;
 
-  static_assert(std::is_same<typename allocator_type::value_type, node_type>::value,
+  // share of parent-child links whose two nodes lie within one cache line / one page
+  struct layout_locality {
+    double same_line = 0;
+    double same_page = 0;
+  };
+  struct compact_report {
+    size_t bytes = 0;
+    layout_locality before;
+    layout_locality after;
+  };
+
+  struct memory_report {
+    size_t node_bytes = 0;      // sizeof(Node) per element: pair, links and aggregate
+    size_t heap_bytes = 0;      // owned by keys and values themselves, as reported by the size hook
+    size_t overhead_bytes = 0;  // estimated allocator headers and rounding, unused compact() slots
+    size_t total() const noexcept { return node_bytes + heap_bytes + overhead_bytes; }
+  };
+
+  static_assert(std::is_same<typename allocator_type::value_type, Node>::value,
                 "bst must have the same value_type as its allocator");
 
   explicit bst() noexcept: root_(nullptr), last_(nullptr) {}
   bst(std::initializer_list<value_type> initializer_list);
-  bst(const bst& other) : size_(other.size_), allocator_(other.allocator_) {
+  bst(const bst& other)
+      : size_(other.size()), allocator_(allocator_traits::select_on_container_copy_construction(other.allocator_)) {
     root_ = copy(other.root_, nullptr);
-    last_ = other.last_;
+    last_ = other.last_ ? mirror_(other.last_, root_) : nullptr;
+  }
+  bst(bst&& other) noexcept
+      : size_(std::exchange(other.size_, 0)),
+        sized_(std::exchange(other.sized_, true)),
+        root_(std::exchange(other.root_, nullptr)),
+        last_(std::exchange(other.last_, nullptr)),
+        max_(std::exchange(other.max_, nullptr)),
+        allocator_(other.allocator_),
+        block_(std::exchange(other.block_, node_block{})) {}
+  bst& operator=(bst other) noexcept {
+    swap(other);
+    return *this;
   }
   ~bst() { del_(root_); }
 
@@ -83,14 +196,51 @@ class bst {
   void insert(std::initializer_list<value_type> initializer_list);
   void insert(iterator i, iterator j);
 
+  // Descends from the lowest ancestor of hint whose key range holds value.first instead of from
+  // the root: O(1) when appending past the maximum, O(distance in the tree) near the hint. An
+  // empty hint starts from the last inserted element. Augmented trees still pull up to the root.
+  iterator insert(iterator hint, value_type value);
+  template<class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return insert(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  // One descent each; a missing key is created from Value{} before update runs
+  void insert_or_assign(value_type value) {
+    upsert(value.first, [&value](Value& current) { current = value.second; });
+  }
+  template<class F>
+  void upsert(const key_type& key, F update) { root_ = upsert_(root_, key, update); }
+
   size_t count(key_type key) const noexcept;
+  // [first, last] of the elements equal to key, both empty iterators if there are none
+  std::pair<iterator, iterator> equal_range(const key_type& key) const;
 
-  void extract(key_type value) {
-    root_ = extract_(root_, value);
-    if (root_ == nullptr) last_ == nullptr;
-  };
+  // Unlinks an element into an owning handle, an empty one if key is missing; the node is moved
+  // out of a compact() block first. insert(node_type&&) relinks it here or into another tree
+  // with an equal allocator, throwing std::invalid_argument otherwise; on a key conflict the
+  // handle keeps the node.
+  node_type extract(const key_type& key);
+  node_type extract(iterator position);
+  iterator insert(node_type&& handle);
 
-  bool contains(key_type value) { return find_(root_, value) != nullptr; }
+  // split moves every element with key >= key into the returned tree; join concatenates two
+  // trees where every key of left is less than every key of right. Both are O(height), unless
+  // nodes of a compact() block have to be moved out of it; without a count_of augmentation the
+  // next size() recounts the elements. join throws std::invalid_argument unless the allocators
+  // are equal.
+  bst split(const key_type& key);
+  static bst join(bst&& left, bst&& right);
+
+  bool contains(key_type value) {
+    Node* found = find_(root_, value);
+    splay_(found);
+    return found != nullptr;
+  }
+
+  // Combined Augment value of all elements with lo <= key <= hi, O(height)
+  aggregate_type aggregate(const key_type& lo, const key_type& hi) const requires augmented_;
+  aggregate_type aggregate() const requires augmented_ { return aggregate_(root_); }
 
   iterator begin() const { return iterator(root_); }
   iterator end() const { return iterator(last_); }
@@ -108,17 +258,57 @@ class bst {
     return root_ ? const_reverse_iterator(root_) : const_reverse_iterator(nullptr);
   }
 
+  // Resumable scans in Order (Preorder, Inorder or Postorder). The coroutine frame keeps only
+  // the current node and steps through parent links, amortized O(1) per element, so a scan
+  // paused after K elements or a time budget resumes without descending from the root again.
+  // Inserts, erases, rotations (splay_tree lookups included) and compact() invalidate it.
+  // Scans of a const tree yield const elements; keys must not be changed through either.
+  template<class Order = Traversal>
+  bst_generator<value_type> scan(Order = Order{}) {
+    return scan_<Order, bst_generator<value_type>>(this);
+  }
+  template<class Order = Traversal>
+  bst_generator<const value_type> scan(Order = Order{}) const {
+    return scan_<Order, bst_generator<const value_type>>(this);
+  }
+  template<class Order = Traversal>
+  bst_async_generator<value_type> scan_async(Order = Order{}) {
+    return scan_<Order, bst_async_generator<value_type>>(this);
+  }
+  template<class Order = Traversal>
+  bst_async_generator<const value_type> scan_async(Order = Order{}) const {
+    return scan_<Order, bst_async_generator<const value_type>>(this);
+  }
+
   size_t erase(Key value) noexcept;
   iterator erase(iterator p) noexcept;
-  const_iterator erase(const_iterator& r) noexcept;
   iterator erase(iterator q1, iterator q2) noexcept;
+  template<class Predicate>
+  size_t erase_if(Predicate pred);
 
+  // O(n) post-order release; clear_async frees the detached nodes on a background thread
+  // and returns immediately, the future yields the number of freed elements
   void clear();
+  std::future<size_t> clear_async();
+
+  // O(1), except for the first call after a split or join of trees without count_of, which is O(n)
+  size_t size() const;
+  allocator_type get_allocator() const noexcept { return allocator_; }
 
-  size_t size() { return size_; }
+  // HeapSize(const value_type&) -> bytes the element owns outside its node, e.g. a string's
+  // buffer; without it the walk over the elements is skipped. Overhead assumes a malloc with
+  // one size word per chunk and 16-byte granularity.
+  template<class HeapSize = no_heap_size>
+  memory_report memory_usage(HeapSize heap_size = {}) const;
   bool operator==(const bst& other) const noexcept;
   bool operator!=(const bst& other) const noexcept;
 
+  // Moves every node into one contiguous block in Order (Preorder, Inorder, Postorder or
+  // VanEmdeBoas for lookups) and frees the old nodes, O(n). Invalidates iterators.
+  template<class Order = Traversal>
+  compact_report compact(Order = Order{});
+  layout_locality locality() const;
+
   void swap(bst& other);
   iterator operator[](size_t i);
   const_iterator operator[](size_t i) const;
@@ -126,217 +316,744 @@ class bst {
   void merge(const bst& other) { return insert(other.begin(), other.end()); }
 };
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::iterator bst<Key, Value, Traversal, Compare, Alloc>::erase(bst::iterator q1,
-                                                                                                       bst::iterator q2) noexcept {
-  auto it = q1;
-  for (; it != q1; it++) {
-    extract((*it).value.first);
-  }
-  return it;
-}
-
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::const_iterator bst<Key,
-                                                               Value,
-                                                               Traversal,
-                                                               Compare,
-                                                               Alloc>::erase(bst::const_iterator& r) noexcept {
-  auto it = cbegin();
-  for (; it != cend(); it++) {
-    if (it == r) {
-      break;
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+class bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::node_handle {
+ private:
+  Node* node_ = nullptr;
+  allocator_type allocator_;
+
+  node_handle(Node* node, const allocator_type& allocator) : node_(node), allocator_(allocator) {}
+  void reset_() noexcept;
+  friend class bst;
+
+ public:
+  node_handle() = default;
+  node_handle(node_handle&& other) noexcept
+      : node_(std::exchange(other.node_, nullptr)), allocator_(other.allocator_) {}
+  node_handle& operator=(node_handle&& other) noexcept {
+    if (this != &other) {
+      reset_();
+      node_ = std::exchange(other.node_, nullptr);
+      allocator_ = other.allocator_;
     }
+    return *this;
+  }
+  ~node_handle() { reset_(); }
+
+  bool empty() const noexcept { return node_ == nullptr; }
+  explicit operator bool() const noexcept { return node_ != nullptr; }
+
+  key_type& key() const noexcept { return node_->value.first; }
+  mapped_type& mapped() const noexcept { return node_->value.second; }
+  allocator_type get_allocator() const { return allocator_; }
+};
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::node_handle::reset_() noexcept {
+  if (node_) {
+    allocator_traits::destroy(allocator_, node_);
+    allocator_traits::deallocate(allocator_, node_, 1);
+    node_ = nullptr;
   }
-  extract((*it).value.first);
-  return it;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::iterator bst<Key,
-                                                         Value,
-                                                         Traversal,
-                                                         Compare,
-                                                         Alloc>::erase(bst::iterator p) noexcept {
-  auto it = begin();
-  for (; it != end(); it++) {
-    if (it == p) {
-      break;
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::node_type bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::extract(const key_type& key) {
+  Node* found = find_(root_, key);
+  if (!found) {
+    return node_type();
+  }
+  detach_(found);
+  return node_type(rehome_(found, block_), allocator_);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::node_type bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::extract(iterator position) {
+  detach_(position.base());
+  return node_type(rehome_(position.base(), block_), allocator_);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::insert(node_type&& handle) {
+  if (handle.empty()) {
+    return iterator(nullptr);
+  }
+  if (!allocator_traits::is_always_equal::value && !(handle.allocator_ == allocator_)) {
+    throw std::invalid_argument("bst::insert: the node was allocated by an unequal allocator");
+  }
+  Node* current = handle.node_;
+  Node* parent = nullptr;
+  Node** link = &root_;
+  while (*link) {
+    parent = *link;
+    if (key_compare{}(current->value.first, parent->value.first)) {
+      link = &parent->left;
+    } else if (multi_ || key_compare{}(parent->value.first, current->value.first)) {
+      link = &parent->right;
+    } else {
+      return iterator(parent);
+    }
+  }
+  handle.node_ = nullptr;
+  *link = current;
+  current->parent = parent;
+  pull_(current);
+  if constexpr (augmented_) {
+    for (Node* ancestor = parent; ancestor; ancestor = ancestor->parent) {
+      pull_(ancestor);
     }
   }
-  extract((*it).value.first);
-  return it;
+  ++size_;
+  last_ = current;
+  if (max_ && !key_compare{}(current->value.first, max_->value.first)) max_ = current;
+  return iterator(current);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-size_t bst<Key, Value, Traversal, Compare, Alloc>::erase(Key value) noexcept {
-  size_t count = 0;
-  for (auto it = begin(); it != end(); it++) {
-    if ((*it).value.first == value) {
-      count++;
-      extract(value);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict> bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::split(const key_type& key) {
+  bst right;
+  right.allocator_ = allocator_;
+  split_(root_, key, root_, right.root_);
+  if (root_) root_->parent = nullptr;
+  if (right.root_) right.root_->parent = nullptr;
+
+  // the moved part must not keep nodes of this tree's block; count it on the same walk.
+  // Otherwise, without count_of, both sizes are left for size() to recount
+  size_t moved = 0;
+  bool counted = counted_ || block_.data;
+  if (block_.data) {
+    std::vector<Node*> pending;
+    if (right.root_) pending.push_back(right.root_);
+    while (!pending.empty()) {
+      Node* current = rehome_(pending.back(), block_);
+      pending.pop_back();
+      if (!current->parent) right.root_ = current;
+      if (current->left) pending.push_back(current->left);
+      if (current->right) pending.push_back(current->right);
+      ++moved;
     }
   }
-  return count;
+  if constexpr (counted_) {
+    moved = right.root_ ? static_cast<size_t>(aggregate_(right.root_)) : 0;
+  }
+  right.size_ = moved;
+  size_ -= moved;
+  right.sized_ = counted;
+  sized_ = sized_ && counted;
+  right.last_ = get_max_(right.root_);
+  if (!last_ || !key_compare{}(last_->value.first, key)) last_ = get_max_(root_);
+  max_ = nullptr;
+  return right;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-size_t bst<Key, Value, Traversal, Compare, Alloc>::count(key_type key) const noexcept {
-  size_t count = 0;
-  for (auto it = begin(); it != end(); it++) {
-    if ((*it).value.first == key) {
-      count++;
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict> bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::join(bst&& left, bst&& right) {
+  // right's nodes and block are freed through left's allocator from now on
+  if (!allocator_traits::is_always_equal::value && !(left.allocator_ == right.allocator_)) {
+    throw std::invalid_argument("bst::join: the trees must have equal allocators");
+  }
+  // equal keys are rejected too: unique trees must not hold them twice, and in a multi tree
+  // join_ would hang right's run below the left side of left's
+  if (left.root_ && right.root_ && !key_compare{}(get_max_(left.root_)->value.first, get_min_(right.root_)->value.first)) {
+    throw std::invalid_argument("bst::join: every key of left must be less than the keys of right");
+  }
+  // the result keeps left's block, right's nodes are moved out of its own
+  if (right.block_.data) {
+    std::vector<Node*> nodes;
+    for (Node* current = get_min_(right.root_); current; current = next_inorder_(current)) {
+      nodes.push_back(current);
+    }
+    for (Node* current : nodes) {
+      Node* moved = left.rehome_(current, right.block_);
+      if (!moved->parent) right.root_ = moved;
+      if (right.last_ == current) right.last_ = moved;
     }
   }
-  return count;
+  bst result(std::move(left));
+  result.root_ = result.join_(result.root_, right.root_);
+  result.size_ += std::exchange(right.size_, 0);
+  result.sized_ = result.sized_ && std::exchange(right.sized_, true);
+  if (right.last_) result.last_ = right.last_;
+  result.max_ = nullptr;
+  right.root_ = nullptr;
+  right.last_ = nullptr;
+  right.max_ = nullptr;
+  return result;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-void bst<Key, Value, Traversal, Compare, Alloc>::insert(bst::iterator i, bst::iterator j) {
+// Iterator erasures unlink the node through its parent pointer, O(height) each. They return the
+// element that followed the last erased one in Traversal order (an empty iterator if there is none).
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::erase(bst::iterator q1,
+                                                                                                                                                               bst::iterator q2) noexcept {
+  // [q1, q2] in Traversal order, inclusive like insert(i, j)
+  if constexpr (std::is_same_v<Traversal, Inorder> && !multi_) {
+    // with unique keys that is the key range [key(q1), key(q2)]; subtrees inside it are freed whole
+    Key lo = (*q1).value.first;
+    Key hi = (*q2).value.first;
+    max_ = nullptr;
+    root_ = erase_range_(root_, lo, hi);
+    if (root_) root_->parent = nullptr;
+    if (!last_) last_ = get_max_(root_);
+
+    Node* next = nullptr;
+    for (Node* current = root_; current;) {
+      if (key_compare{}(hi, current->value.first)) {
+        next = current;
+        current = current->left;
+      } else {
+        current = current->right;
+      }
+    }
+    return iterator(next);
+  } else {
+    // unlinking relinks nodes without moving elements, so the walk is done before any of it
+    std::vector<Node*> covered;
+    Node* current = q1.base();
+    while (current) {
+      covered.push_back(current);
+      Node* next = next_<Traversal>(current);
+      if (current == q2.base()) {
+        current = next;
+        break;
+      }
+      current = next;
+    }
+    for (Node* node : covered) {
+      unlink_(node);
+    }
+    return iterator(current);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator bst<Key,
+                                                                                     Value,
+                                                                                     Traversal,
+                                                                                     Compare,
+                                                                                     Alloc,
+                                                                                     Augment,
+                                                                                     Balance,
+                                                                                     Conflict>::erase(bst::iterator p) noexcept {
+  Node* next = next_<Traversal>(p.base());
+  unlink_(p.base());
+  return iterator(next);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Predicate>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::erase_if(Predicate pred) {
+  // one in-order pass frees the matching nodes, the survivors are relinked into a balanced tree
+  // parent links are still walked after a node is judged, so nodes are freed only afterwards
+  std::vector<Node*> kept;
+  kept.reserve(size());
+  for (Node* current = get_min_(root_); current; current = next_inorder_(current)) {
+    kept.push_back(current);
+  }
+  auto erased_begin = std::stable_partition(kept.begin(), kept.end(), [&pred](Node* current) {
+    return !pred(std::as_const(current->value));
+  });
+  for (auto it = erased_begin; it != kept.end(); ++it) {
+    free_(*it);
+  }
+  size_t erased = kept.end() - erased_begin;
+  kept.erase(erased_begin, kept.end());
+  size_ = kept.size();
+  sized_ = true;
+  std::vector<std::pair<size_t, size_t>> runs;
+  if constexpr (multi_) {
+    runs.resize(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+      bool continues = i && !key_compare{}(kept[i - 1]->value.first, kept[i]->value.first);
+      runs[i].first = continues ? runs[i - 1].first : i;
+    }
+    for (size_t i = kept.size(); i-- > 0;) {
+      bool continued = i + 1 < kept.size() && runs[i + 1].first == runs[i].first;
+      runs[i].second = continued ? runs[i + 1].second : i + 1;
+    }
+  }
+  root_ = build_(kept.data(), runs.data(), 0, kept.size(), nullptr);
+  last_ = kept.empty() ? nullptr : kept.back();
+  max_ = last_;
+  return erased;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::erase(Key value) noexcept {
+  size_t before = size_;
+  if constexpr (multi_) {
+    max_ = nullptr;
+    root_ = erase_equal_(root_, value);
+    if (root_) root_->parent = nullptr;
+    if (!last_) last_ = get_max_(root_);
+  } else {
+    extract(value);
+  }
+  return before - size_;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::count(key_type key) const noexcept {
+  if constexpr (!multi_) {
+    return find_(root_, key) != nullptr;
+  } else if constexpr (counted_) {
+    // elements <= key minus elements < key, both ranks summed from subtree counts along one path
+    size_t count = 0;
+    for (Node* current = root_; current;) {
+      if (key_compare{}(key, current->value.first)) {
+        current = current->left;
+      } else {
+        count += aggregate_(current->left) + 1;
+        current = current->right;
+      }
+    }
+    for (Node* current = root_; current;) {
+      if (key_compare{}(current->value.first, key)) {
+        count -= aggregate_(current->left) + 1;
+        current = current->right;
+      } else {
+        current = current->left;
+      }
+    }
+    return count;
+  } else {
+    return count_equal_(root_, key);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::insert(bst::iterator i, bst::iterator j) {
   for (; i != j; i++) {
     insert((*i).value);
   }
   insert((*i).value);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-void bst<Key, Value, Traversal, Compare, Alloc>::clear() {
-  size_t bst_size = size_;
-  for (size_t i = 0; i < bst_size; i++) {
-    extract((*operator[](0)).value.first);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator bst<Key,
+                                                                                     Value,
+                                                                                     Traversal,
+                                                                                     Compare,
+                                                                                     Alloc,
+                                                                                     Augment,
+                                                                                     Balance,
+                                                                                     Conflict>::insert(bst::iterator hint,
+                                                                                                       value_type value) {
+  Node* start = finger_(hint.base(), value.first);
+  if (!start) {
+    root_ = insert_(root_, value);
+    return iterator(root_);
+  }
+  size_t before = size_;
+  insert_(start, value);
+  if constexpr (augmented_) {
+    for (Node* ancestor = start->parent; ancestor; ancestor = ancestor->parent) {
+      pull_(ancestor);
+    }
+  }
+  return iterator(size_ != before ? last_ : find_(start, value.first));
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::clear() {
+  del_(root_);
+  root_ = nullptr;
+  last_ = nullptr;
+  max_ = nullptr;
+  size_ = 0;
+  sized_ = true;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+std::future<size_t> bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::clear_async() {
+  std::packaged_task<size_t()> task([allocator = allocator_, block = block_, root = root_]() mutable {
+    return release_(allocator, block, root);
+  });
+  std::future<size_t> freed = task.get_future();
+  std::thread(std::move(task)).detach();
+  root_ = nullptr;
+  last_ = nullptr;
+  max_ = nullptr;
+  block_ = node_block{};
+  size_ = 0;
+  sized_ = true;
+  return freed;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Order>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::compact_report bst<Key,
+                                                                                           Value,
+                                                                                           Traversal,
+                                                                                           Compare,
+                                                                                           Alloc,
+                                                                                           Augment,
+                                                                                           Balance,
+                                                                                           Conflict>::compact(Order) {
+  compact_report report;
+  report.before = locality();
+  std::vector<Node*> order;
+  order.reserve(size());
+  layout_<Order>(order);
+  if (order.empty()) {
+    return report;
+  }
+
+  node_block block{allocator_traits::allocate(allocator_, order.size()), order.size(), order.size()};
+  for (size_t i = 0; i < order.size(); ++i) {
+    Node* fresh = block.data + i;
+    allocator_traits::construct(allocator_, fresh, std::move(order[i]->value));
+    static_cast<augment_node<Augment>&>(*fresh) = *order[i];
+    fresh->parent = order[i]->parent;
   }
+  // each old node forwards to its copy through its parent link while the links are rewritten
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i]->parent = block.data + i;
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    Node* fresh = block.data + i;
+    fresh->left = order[i]->left ? order[i]->left->parent : nullptr;
+    fresh->right = order[i]->right ? order[i]->right->parent : nullptr;
+    if (fresh->parent) fresh->parent = fresh->parent->parent;
+  }
+  root_ = root_->parent;
+  if (last_) last_ = last_->parent;
+  if (max_) max_ = max_->parent;
+  for (Node* old : order) {
+    free_(old);
+  }
+  block_ = block;
+
+  report.bytes = block.capacity * sizeof(Node);
+  report.after = locality();
+  return report;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::bst(std::initializer_list<value_type> initializer_list) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::layout_locality bst<Key,
+                                                                                            Value,
+                                                                                            Traversal,
+                                                                                            Compare,
+                                                                                            Alloc,
+                                                                                            Augment,
+                                                                                            Balance,
+                                                                                            Conflict>::locality() const {
+  size_t links = 0;
+  size_t same_line = 0;
+  size_t same_page = 0;
+  for (Node* current = get_min_(root_); current; current = next_inorder_(current)) {
+    if (!current->parent) continue;
+    auto child = reinterpret_cast<std::uintptr_t>(current);
+    auto parent = reinterpret_cast<std::uintptr_t>(current->parent);
+    std::uintptr_t distance = child < parent ? parent - child : child - parent;
+    ++links;
+    same_line += distance < 64;
+    same_page += distance < 4096;
+  }
+  if (!links) {
+    return {};
+  }
+  return {static_cast<double>(same_line) / links, static_cast<double>(same_page) / links};
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class HeapSize>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::memory_report bst<Key,
+                                                                                         Value,
+                                                                                         Traversal,
+                                                                                         Compare,
+                                                                                         Alloc,
+                                                                                         Augment,
+                                                                                         Balance,
+                                                                                         Conflict>::memory_usage(HeapSize heap_size) const {
+  auto chunk = [](size_t bytes) { return std::max<size_t>(32, (bytes + sizeof(size_t) + 15) & ~size_t{15}); };
+  memory_report report;
+  report.node_bytes = size() * sizeof(Node);
+  report.overhead_bytes = (size_ - block_.live) * (chunk(sizeof(Node)) - sizeof(Node));
+  if (block_.data) {
+    report.overhead_bytes += chunk(block_.capacity * sizeof(Node)) - block_.live * sizeof(Node);
+  }
+  if constexpr (!std::is_same_v<HeapSize, no_heap_size>) {
+    for (Node* current = get_min_(root_); current; current = next_inorder_(current)) {
+      report.heap_bytes += heap_size(std::as_const(current->value));
+    }
+  }
+  return report;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::bst(std::initializer_list<value_type> initializer_list) {
   insert(initializer_list);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-void bst<Key, Value, Traversal, Compare, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::insert(std::initializer_list<value_type> initializer_list) {
   for (auto item : initializer_list) {
     insert(item);
   }
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::iterator bst<Key, Value, Traversal, Compare, Alloc>::operator[](size_t i) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::operator[](size_t i) {
   return iterator(begin() + i);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::const_iterator bst<Key,
-                                                               Value,
-                                                               Traversal,
-                                                               Compare,
-                                                               Alloc>::operator[](size_t i) const {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::const_iterator bst<Key,
+                                                                                           Value,
+                                                                                           Traversal,
+                                                                                           Compare,
+                                                                                           Alloc,
+                                                                                           Augment,
+                                                                                           Balance,
+                                                                                           Conflict>::operator[](size_t i) const {
   return iterator(cbegin() + i);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-void bst<Key, Value, Traversal, Compare, Alloc>::del_(Node* current) {
-  if (!current) return;
-  del_(current->left);
-  del_(current->right);
-  allocator_traits::destroy(allocator_, current);
-  allocator_traits::deallocate(allocator_, current, 1);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::del_(Node* current) {
+  return release_(allocator_, block_, current);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::release_(allocator_type& allocator,
+                                                                                        node_block& block,
+                                                                                        Node* current) {
+  // iterative post-order over parent links: no recursion depth limit on degenerate trees
+  size_t count = 0;
+  Node* stop = current ? current->parent : nullptr;
+  while (current != stop) {
+    if (current->left) {
+      current = current->left;
+    } else if (current->right) {
+      current = current->right;
+    } else {
+      Node* parent = current->parent;
+      if (parent != stop) {
+        (parent->left == current ? parent->left : parent->right) = nullptr;
+      }
+      free_(allocator, block, current);
+      ++count;
+      current = parent;
+    }
+  }
+  return count;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::free_(allocator_type& allocator,
+                                                                                   node_block& block,
+                                                                                   Node* current) {
+  allocator_traits::destroy(allocator, current);
+  if (owns_(block, current)) {
+    if (--block.live == 0) {
+      allocator_traits::deallocate(allocator, block.data, block.capacity);
+      block = node_block{};
+    }
+  } else {
+    allocator_traits::deallocate(allocator, current, 1);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::rehome_(Node* current, node_block& block) {
+  if (!owns_(block, current)) {
+    return current;
+  }
+  Node* fresh = allocator_traits::allocate(allocator_, 1);
+  allocator_traits::construct(allocator_, fresh, std::move(current->value));
+  static_cast<augment_node<Augment>&>(*fresh) = *current;
+  fresh->left = current->left;
+  fresh->right = current->right;
+  fresh->parent = current->parent;
+  fresh->visited = current->visited;
+  if (fresh->parent) (fresh->parent->left == current ? fresh->parent->left : fresh->parent->right) = fresh;
+  if (fresh->left) fresh->left->parent = fresh;
+  if (fresh->right) fresh->right->parent = fresh;
+  free_(allocator_, block, current);
+  return fresh;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::split_(Node* current, const Key& key, Node*& left, Node*& right) {
+  // keys below key go left; each node on the search path keeps the side it belongs to
+  if (!current) {
+    left = nullptr;
+    right = nullptr;
+    return;
+  }
+  if (key_compare{}(current->value.first, key)) {
+    split_(current->right, key, current->right, right);
+    if (current->right) current->right->parent = current;
+    left = current;
+  } else {
+    split_(current->left, key, left, current->left);
+    if (current->left) current->left->parent = current;
+    right = current;
+  }
+  pull_(current);
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key,
-                                                      Value,
-                                                      Traversal,
-                                                      Compare,
-                                                      Alloc>::insert_(bst::Node* current,
-                                                                      std::pair<Key, Value> value) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Order>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::layout_(std::vector<Node*>& order) const {
+  if (!root_) return;
+  if constexpr (std::is_same_v<Order, Inorder>) {
+    for (Node* current = get_min_(root_); current; current = next_inorder_(current)) {
+      order.push_back(current);
+    }
+  } else if constexpr (std::is_same_v<Order, Preorder> || std::is_same_v<Order, Postorder>) {
+    // postorder is preorder with the children swapped, reversed
+    constexpr bool post = std::is_same_v<Order, Postorder>;
+    std::vector<Node*> pending{root_};
+    while (!pending.empty()) {
+      Node* current = pending.back();
+      pending.pop_back();
+      order.push_back(current);
+      Node* first = post ? current->right : current->left;
+      Node* second = post ? current->left : current->right;
+      if (second) pending.push_back(second);
+      if (first) pending.push_back(first);
+    }
+    if constexpr (post) std::reverse(order.begin(), order.end());
+  } else if constexpr (std::is_same_v<Order, VanEmdeBoas>) {
+    // subtree roots with the number of levels still to lay out; the top half of a subtree is
+    // laid out first, then each subtree hanging below it, recursively
+    size_t height = 0;
+    std::vector<std::pair<Node*, size_t>> level{{root_, 0}};
+    for (size_t i = 0; i < level.size(); ++i) {
+      auto [current, depth] = level[i];
+      height = std::max(height, depth + 1);
+      if (current->left) level.push_back({current->left, depth + 1});
+      if (current->right) level.push_back({current->right, depth + 1});
+    }
+    std::vector<std::pair<Node*, size_t>> pending{{root_, height}};
+    while (!pending.empty()) {
+      auto [top, levels] = pending.back();
+      pending.pop_back();
+      if (levels == 1) {
+        order.push_back(top);
+        continue;
+      }
+      size_t upper = levels / 2;
+      // frontier: nodes exactly upper levels below top, left to right
+      std::vector<Node*> frontier{top};
+      for (size_t depth = 0; depth < upper; ++depth) {
+        std::vector<Node*> next;
+        for (Node* current : frontier) {
+          if (current->left) next.push_back(current->left);
+          if (current->right) next.push_back(current->right);
+        }
+        frontier.swap(next);
+      }
+      for (auto it = frontier.rbegin(); it != frontier.rend(); ++it) {
+        pending.push_back({*it, levels - upper});
+      }
+      // the upper part is top cut off after upper levels, pushed last so it is laid out first
+      pending.push_back({top, upper});
+    }
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::insert_(bst::Node* current,
+                                                                                                     std::pair<Key, Value> value) {
   if (current == nullptr) {
     Node* new_node = allocator_traits::allocate(allocator_, 1);
     allocator_traits::construct(allocator_, new_node, value);
+    pull_(new_node);
+    if (max_ && !key_compare{}(new_node->value.first, max_->value.first)) max_ = new_node;
     last_ = new_node;
     ++size_;
     return last_;
   } else if (key_compare{}(value.first, current->value.first)) {
     current->left = insert_(current->left, value);
     current->left->parent = current;
-  } else if (key_compare{}(current->value.first, value.first)) {
+  } else if (multi_ || key_compare{}(current->value.first, value.first)) {
     current->right = insert_(current->right, value);
     current->right->parent = current;
-  } else if (value.second < current->value.second) {
-    current->value.second = value.second;
+  } else if constexpr (!multi_) {
+    Conflict::resolve(current->value.second, value.second);
   }
+  pull_(current);
   return current;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key,
-                                                      Value,
-                                                      Traversal,
-                                                      Compare,
-                                                      Alloc>::get_min_(bst::Node* current) {
-  if (current != nullptr && current->left != nullptr) {
-    return get_min_(current->left);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class F>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::upsert_(bst::Node* current,
+                                                                                                     const Key& key,
+                                                                                                     F& update) {
+  if (current == nullptr) {
+    Node* new_node = allocator_traits::allocate(allocator_, 1);
+    allocator_traits::construct(allocator_, new_node, std::pair<Key, Value>(key, Value{}));
+    update(new_node->value.second);
+    pull_(new_node);
+    if (max_ && !key_compare{}(new_node->value.first, max_->value.first)) max_ = new_node;
+    last_ = new_node;
+    ++size_;
+    return last_;
+  } else if (key_compare{}(key, current->value.first)) {
+    current->left = upsert_(current->left, key, update);
+    current->left->parent = current;
+  } else if (key_compare{}(current->value.first, key)) {
+    current->right = upsert_(current->right, key, update);
+    current->right->parent = current;
+  } else {
+    update(current->value.second);
   }
+  pull_(current);
   return current;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key,
-                                                      Value,
-                                                      Traversal,
-                                                      Compare,
-                                                      Alloc>::get_max_(bst::Node* current) {
-  if (current != nullptr && current->right != nullptr) {
-    return get_min_(current->right);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::get_min_(bst::Node* current) {
+  if (current != nullptr && current->left != nullptr) {
+    return get_min_(current->left);
   }
   return current;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key,
-                                                      Value,
-                                                      Traversal,
-                                                      Compare,
-                                                      Alloc>::extract_(bst::Node* current, Key value) {
-  if (!current) return nullptr;
-
-  if (key_compare{}(value, current->value.first)) {
-    current->left = extract_(current->left, value);
-    if (current->left) current->left->parent = current;
-  } else if (key_compare{}(current->value.first, value)) {
-    current->right = extract_(current->right, value);
-    if (current->right) current->right->parent = current;
-  } else {
-    if (!current->left) {
-      Node* temp = current->right;
-      allocator_traits::destroy(allocator_, current);
-      allocator_traits::deallocate(allocator_, current, 1);
-      --size_;
-      if (last_ == current) {
-        last_ = (temp) ? get_max_(temp) : nullptr;
-      }
-      return temp;
-    } else if (!current->right) {
-      Node* temp = current->left;
-      allocator_traits::destroy(allocator_, current);
-      allocator_traits::deallocate(allocator_, current, 1);
-      --size_;
-      if (last_ == current) {
-        last_ = get_max_(temp);
-      }
-      return temp;
-    }
-
-    Node* successor = get_min_(current->right);
-    current->value = successor->value;
-    current->right = extract_(current->right, successor->value.first);
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::get_max_(bst::Node* current) {
+  if (current != nullptr && current->right != nullptr) {
+    return get_max_(current->right);
   }
-
   return current;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key, Value, Traversal, Compare, Alloc>::find_(bst::Node* current,
-                                                                                                    key_type value) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::find_(bst::Node* current,
+                                                                                                                                                            key_type value) const {
   if (!current) { return nullptr; }
   if (key_compare{}(value, current->value.first)) {
     return find_(current->left, value);
@@ -346,9 +1063,9 @@ bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key, Value, Traversal, Com
   return current;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bool bst<Key, Value, Traversal, Compare, Alloc>::operator==(const bst& other) const noexcept {
-  if (size_ != other.size_) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bool bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::operator==(const bst& other) const noexcept {
+  if (size() != other.size()) {
     return false;
   }
   iterator it_1 = begin();
@@ -364,14 +1081,14 @@ bool bst<Key, Value, Traversal, Compare, Alloc>::operator==(const bst& other) co
   return true;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-bool bst<Key, Value, Traversal, Compare, Alloc>::operator!=(const bst& other) const noexcept {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bool bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::operator!=(const bst& other) const noexcept {
   return !(this->operator==(other));
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-typename bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key, Value, Traversal, Compare, Alloc>::copy(Node* other,
-                                                                                                            Node* parent) {
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+typename bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::copy(Node* other,
+                                                                                                                                                                    Node* parent) {
   if (other == nullptr) {
     return nullptr;
   }
@@ -380,15 +1097,457 @@ typename bst<Key, Value, Traversal, Compare, Alloc>::Node* bst<Key, Value, Trave
   new_node->parent = parent;
   new_node->left = copy(other->left, new_node);
   new_node->right = copy(other->right, new_node);
+  pull_(new_node);
   return new_node;
 }
 
-template<class Key, class Value, class Traversal, class Compare, class Alloc>
-void bst<Key, Value, Traversal, Compare, Alloc>::swap(bst& other) {
-  if (*this == other) {
-    return;
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+typename bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::mirror_(Node* node,
+                                                                                                                                                                       Node* root) {
+  if (!node->parent) {
+    return root;
+  }
+  Node* parent = mirror_(node->parent, root);
+  return node == node->parent->left ? parent->left : parent->right;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::size() const {
+  if (!sized_) {
+    size_ = 0;
+    for (Node* current = get_min_(root_); current; current = next_inorder_(current)) {
+      ++size_;
+    }
+    sized_ = true;
+  }
+  return size_;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::swap(bst& other) {
+  std::swap(size_, other.size_);
+  std::swap(sized_, other.sized_);
+  std::swap(root_, other.root_);
+  std::swap(last_, other.last_);
+  std::swap(max_, other.max_);
+  std::swap(allocator_, other.allocator_);
+  std::swap(block_, other.block_);
+}
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+Augment::value_type bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::aggregate_(Node* current) requires augmented_ {
+  return current ? current->aggregate : Augment::identity();
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+Augment::value_type bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::lift_(Node* current) requires augmented_ {
+  return Augment::lift(current->value.first, current->value.second);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::pull_(Node* current) {
+  if constexpr (augmented_) {
+    current->aggregate = Augment::combine(Augment::combine(aggregate_(current->left), lift_(current)),
+                                          aggregate_(current->right));
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+Augment::value_type bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::aggregate(const key_type& lo,
+                                                                                                      const key_type& hi) const requires augmented_ {
+  Node* split = root_;
+  while (split) {
+    if (key_compare{}(split->value.first, lo)) {
+      split = split->right;
+    } else if (key_compare{}(hi, split->value.first)) {
+      split = split->left;
+    } else {
+      break;
+    }
+  }
+  if (!split) {
+    return Augment::identity();
+  }
+
+  // every node on the left path with key >= lo brings its right subtree along, and vice versa
+  aggregate_type left = Augment::identity();
+  for (Node* current = split->left; current;) {
+    if (key_compare{}(current->value.first, lo)) {
+      current = current->right;
+    } else {
+      left = Augment::combine(Augment::combine(lift_(current), aggregate_(current->right)), left);
+      current = current->left;
+    }
+  }
+  aggregate_type right = Augment::identity();
+  for (Node* current = split->right; current;) {
+    if (key_compare{}(hi, current->value.first)) {
+      current = current->left;
+    } else {
+      right = Augment::combine(right, Augment::combine(aggregate_(current->left), lift_(current)));
+      current = current->right;
+    }
+  }
+  return Augment::combine(Augment::combine(left, lift_(split)), right);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::rotate_(Node* current) {
+  Node* parent = current->parent;
+  Node* grandparent = parent->parent;
+  if (current == parent->left) {
+    parent->left = current->right;
+    if (parent->left) parent->left->parent = parent;
+    current->right = parent;
+  } else {
+    parent->right = current->left;
+    if (parent->right) parent->right->parent = parent;
+    current->left = parent;
+  }
+  parent->parent = current;
+  current->parent = grandparent;
+  if (!grandparent) {
+    root_ = current;
+  } else if (grandparent->left == parent) {
+    grandparent->left = current;
+  } else {
+    grandparent->right = current;
+  }
+  pull_(parent);
+  pull_(current);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::splay_(Node* current) {
+  if constexpr (!std::is_same_v<Balance, plain_tree>) {
+    while (current && current->parent) {
+      Node* parent = current->parent;
+      Node* grandparent = parent->parent;
+      if (!grandparent) {
+        rotate_(current);
+      } else if ((grandparent->left == parent) == (parent->left == current)) {
+        rotate_(parent);
+        if constexpr (std::is_same_v<Balance, semi_splay_tree>) {
+          current = parent;
+        } else {
+          rotate_(current);
+        }
+      } else {
+        rotate_(current);
+        rotate_(current);
+      }
+    }
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+std::pair<typename bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator,
+          typename bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::iterator> bst<Key,
+                                                                                                         Value,
+                                                                                                         Traversal,
+                                                                                                         Compare,
+                                                                                                         Alloc,
+                                                                                                         Augment,
+                                                                                                         Balance,
+                                                                                                         Conflict>::equal_range(const key_type& key) const {
+  Node* first = nullptr;
+  for (Node* current = root_; current;) {
+    if (key_compare{}(current->value.first, key)) {
+      current = current->right;
+    } else {
+      if (!key_compare{}(key, current->value.first)) first = current;
+      current = current->left;
+    }
+  }
+  Node* last = nullptr;
+  for (Node* current = first; current;) {
+    if (key_compare{}(key, current->value.first)) {
+      current = current->left;
+    } else {
+      last = current;
+      current = current->right;
+    }
   }
-  bst<Key, Value, Traversal, Alloc> tmp = other;
-  other = *this;
-  *this = tmp;
-}
\ No newline at end of file
+  return {iterator(first), iterator(last)};
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+size_t bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::count_equal_(Node* current,
+                                                                                           const Key& key) const {
+  if (!current) return 0;
+
+  if (key_compare{}(key, current->value.first)) {
+    return count_equal_(current->left, key);
+  } else if (key_compare{}(current->value.first, key)) {
+    return count_equal_(current->right, key);
+  }
+  return 1 + count_equal_(current->left, key) + count_equal_(current->right, key);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::erase_equal_(Node* current,
+                                                                                                          const Key& key) {
+  if (!current) return nullptr;
+
+  if (key_compare{}(key, current->value.first)) {
+    current->left = erase_equal_(current->left, key);
+    if (current->left) current->left->parent = current;
+  } else if (key_compare{}(current->value.first, key)) {
+    current->right = erase_equal_(current->right, key);
+    if (current->right) current->right->parent = current;
+  } else {
+    Node* left = erase_equal_(current->left, key);
+    Node* right = erase_equal_(current->right, key);
+    if (last_ == current) last_ = nullptr;
+    free_(current);
+    --size_;
+    return join_(left, right);
+  }
+
+  pull_(current);
+  return current;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::join_(Node* left,
+                                                                                                   Node* right) {
+  // every key of left is <= every key of right; the minimum of right becomes the common root
+  if (!left || !right) {
+    return left ? left : right;
+  }
+  Node* top = get_min_(right);
+  if (top != right) {
+    Node* parent = top->parent;
+    parent->left = top->right;
+    if (parent->left) parent->left->parent = parent;
+    top->right = right;
+    right->parent = top;
+    for (Node* current = parent; current != top; current = current->parent) {
+      pull_(current);
+    }
+  }
+  top->left = left;
+  left->parent = top;
+  top->parent = nullptr;
+  pull_(top);
+  return top;
+}
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::detach_(Node* current) {
+  Node* parent = current->parent;
+  Node* replacement = join_(current->left, current->right);
+  if (!parent) {
+    root_ = replacement;
+  } else if (parent->left == current) {
+    parent->left = replacement;
+  } else {
+    parent->right = replacement;
+  }
+  if (replacement) replacement->parent = parent;
+  if constexpr (augmented_) {
+    for (Node* ancestor = parent; ancestor; ancestor = ancestor->parent) {
+      pull_(ancestor);
+    }
+  }
+  current->left = nullptr;
+  current->right = nullptr;
+  current->parent = nullptr;
+  current->visited = false;
+  pull_(current);
+  --size_;
+  if (max_ == current) max_ = nullptr;
+  if (last_ == current) last_ = get_max_(root_);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+void bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::unlink_(Node* current) {
+  detach_(current);
+  free_(current);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::erase_range_(Node* current,
+                                                                                                          const Key& lo,
+                                                                                                          const Key& hi,
+                                                                                                          bool above_lo,
+                                                                                                          bool below_hi) {
+  if (!current) return nullptr;
+
+  // above_lo / below_hi: every key of the subtree is already known to satisfy that bound
+  if (above_lo && below_hi) {
+    if (last_ && !key_compare{}(last_->value.first, lo) && !key_compare{}(hi, last_->value.first)) last_ = nullptr;
+    size_ -= del_(current);
+    return nullptr;
+  }
+  bool current_above_lo = above_lo || !key_compare{}(current->value.first, lo);
+  bool current_below_hi = below_hi || !key_compare{}(hi, current->value.first);
+  if (current_above_lo && current_below_hi) {
+    Node* left = erase_range_(current->left, lo, hi, above_lo, true);
+    Node* right = erase_range_(current->right, lo, hi, true, below_hi);
+    current->left = nullptr;
+    current->right = nullptr;
+    if (last_ == current) last_ = nullptr;
+    size_ -= del_(current);
+    return join_(left, right);
+  }
+  if (current_above_lo) {
+    current->left = erase_range_(current->left, lo, hi, above_lo, below_hi);
+    if (current->left) current->left->parent = current;
+  } else {
+    current->right = erase_range_(current->right, lo, hi, above_lo, below_hi);
+    if (current->right) current->right->parent = current;
+  }
+  pull_(current);
+  return current;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::next_inorder_(Node* current) {
+  if (current->right) {
+    current = current->right;
+    while (current->left) current = current->left;
+    return current;
+  }
+  while (current->parent && current == current->parent->right) {
+    current = current->parent;
+  }
+  return current->parent;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Order>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::first_(Node* current) {
+  if (!current || std::is_same_v<Order, Preorder>) {
+    return current;
+  }
+  while (current->left || (std::is_same_v<Order, Postorder> && current->right)) {
+    current = current->left ? current->left : current->right;
+  }
+  return current;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Order>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::next_(Node* current) {
+  if constexpr (std::is_same_v<Order, Preorder>) {
+    if (current->left || current->right) {
+      return current->left ? current->left : current->right;
+    }
+    while (current->parent && (current == current->parent->right || !current->parent->right)) {
+      current = current->parent;
+    }
+    return current->parent ? current->parent->right : nullptr;
+  } else if constexpr (std::is_same_v<Order, Inorder>) {
+    return next_inorder_(current);
+  } else {
+    static_assert(std::is_same_v<Order, Postorder>, "scan supports Preorder, Inorder and Postorder");
+    Node* parent = current->parent;
+    return (parent && current == parent->left && parent->right) ? first_<Order>(parent->right) : parent;
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+template<class Order, class Generator>
+Generator bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::scan_(const bst* tree) {
+  // root_ is read on the first resume; the successor is taken only once the consumer has moved
+  // past the current element
+  for (Node* current = first_<Order>(tree->root_); current; current = next_<Order>(current)) {
+    co_yield current->value;
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::build_(Node** nodes,
+                                                                                                    const std::pair<size_t, size_t>* runs,
+                                                                                                    size_t first,
+                                                                                                    size_t last,
+                                                                                                    Node* parent) {
+  if (first == last) return nullptr;
+
+  size_t middle = first + (last - first) / 2;
+  if constexpr (multi_) {
+    // equal keys only ever hang to the right, as insert_ puts them, so the subtree root is the
+    // run boundary in [first, last) nearest to the middle; equal_range relies on it
+    size_t begin = std::max(runs[middle].first, first);
+    size_t end = runs[middle].second;
+    middle = (end < last && end - middle < middle - begin) ? end : begin;
+  }
+  Node* current = nodes[middle];
+  current->parent = parent;
+  current->visited = false;
+  current->left = build_(nodes, runs, first, middle, current);
+  current->right = build_(nodes, runs, middle + 1, last, current);
+  pull_(current);
+  return current;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc, class Augment, class Balance, class Conflict>
+bst<Key, Value, Traversal, Compare, Alloc, Augment, Balance, Conflict>::Node* bst<Key,
+                                                                                  Value,
+                                                                                  Traversal,
+                                                                                  Compare,
+                                                                                  Alloc,
+                                                                                  Augment,
+                                                                                  Balance,
+                                                                                  Conflict>::finger_(Node* finger,
+                                                                                                     const Key& key) {
+  // the subtree to descend from: its key range is bounded by the nearest ancestors it hangs left
+  // and right of, so climbing stops at the first ancestor on the far side of key
+  if (!root_) return nullptr;
+  if (!max_) max_ = get_max_(root_);
+  if (!key_compare{}(key, max_->value.first)) {
+    return max_;
+  }
+  Node* current = finger ? finger : last_;
+  // bst_multi places equal keys after the existing ones, so those climb as if greater
+  if (key_compare{}(current->value.first, key) || (multi_ && !key_compare{}(key, current->value.first))) {
+    while (current->parent && !(current == current->parent->left && key_compare{}(key, current->parent->value.first))) {
+      current = current->parent;
+    }
+  } else if (key_compare{}(key, current->value.first)) {
+    while (current->parent && !(current == current->parent->right && key_compare{}(current->parent->value.first, key))) {
+      current = current->parent;
+    }
+  }
+  return current;
+}
+
+// bst that keeps equal keys in insertion order and counts them through subtree sizes
+template<class Key, class Value, class Traversal = Preorder,
+    class Compare = std::less<Key>,
+    class Alloc = std::allocator<std::pair<Key, Value>>>
+using bst_multi = bst<Key, Value, Traversal, Compare, Alloc, count_of<>, plain_tree, keep_all>;
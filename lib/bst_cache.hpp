@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+
+#include <lib/bst.hpp>
+#include <lib/policy/eviction.hpp>
+
+// Mapped type of a bst_cache node: the cached value plus its place in the recency list.
+// Elements with the same use count form one bucket, ordered oldest to newest.
+template<class Key, class Value, class Alloc>
+struct cache_entry {
+  using slot = std::pair<Key, cache_entry>;
+  struct bucket {
+    size_t uses = 0;
+    slot* oldest = nullptr;
+    slot* newest = nullptr;
+  };
+  using bucket_list = std::list<bucket, typename std::allocator_traits<Alloc>::template rebind_alloc<bucket>>;
+
+  Value value{};
+  slot* older = nullptr;
+  slot* newer = nullptr;
+  typename bucket_list::iterator bucket_;
+
+  // bst_iterator compares elements, not positions
+  bool operator==(const cache_entry& other) const { return value == other.value; }
+};
+
+// bst with a capacity: an insert past it evicts one element chosen by Eviction. The recency list
+// is threaded through the nodes themselves and lfu splits it into one bucket per use count, so
+// a touch is O(1) after the lookup and an eviction costs one O(height) descent to unlink the
+// victim. Nodes are only unlinked, never copied into one another, so the list links stay valid.
+template<class Key, class Value, class Eviction = lru, class Traversal = Preorder,
+    class Compare = std::less<Key>,
+    class Alloc = std::allocator<std::pair<Key, Value>>>
+class bst_cache : protected bst<Key, cache_entry<Key, Value, Alloc>, Traversal, Compare,
+                                typename std::allocator_traits<Alloc>::template rebind_alloc<
+                                    std::pair<Key, cache_entry<Key, Value, Alloc>>>,
+                                no_augment, plain_tree, overwrite> {
+ private:
+  using entry = cache_entry<Key, Value, Alloc>;
+  using slot = entry::slot;
+  using bucket = entry::bucket;
+  using base = bst<Key, entry, Traversal, Compare,
+                   typename std::allocator_traits<Alloc>::template rebind_alloc<slot>,
+                   no_augment, plain_tree, overwrite>;
+  using Node = base::Node;
+
+  static constexpr bool frequency_ = std::is_same_v<Eviction, lfu>;
+
+  typename entry::bucket_list buckets_;
+  size_t capacity_;
+
+  void attach_(slot* current, entry::bucket_list::iterator to);
+  void detach_(slot* current);
+  void touch_(slot* current);
+  void evict_();
+
+ public:
+  using typename base::iterator;
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key, Value>;
+  using size_type = std::size_t;
+
+  struct cache_stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+  };
+
+  // capacity is at least one element
+  explicit bst_cache(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+  bst_cache(const bst_cache&) = delete;
+  bst_cache& operator=(const bst_cache&) = delete;
+
+  using base::begin;
+  using base::end;
+  using base::size;
+
+  // inserts or overwrites, touching the element either way
+  void insert(const value_type& value);
+  void insert(std::initializer_list<value_type> initializer_list);
+
+  // counts a hit and touches the element, or counts a miss and returns an empty iterator
+  iterator find(const key_type& key);
+  // neither touches nor counts
+  bool contains(const key_type& key) const { return this->find_(this->root_, key) != nullptr; }
+
+  size_t erase(const key_type& key);
+  void clear();
+
+  size_t capacity() const noexcept { return capacity_; }
+  // shrinking evicts down to the new capacity
+  void capacity(size_t capacity);
+
+  const cache_stats& stats() const noexcept { return stats_; }
+
+ private:
+  cache_stats stats_;
+};
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::attach_(slot* current,
+                                                                         entry::bucket_list::iterator to) {
+  entry& linked = current->second;
+  linked.bucket_ = to;
+  linked.older = to->newest;
+  linked.newer = nullptr;
+  (to->newest ? to->newest->second.newer : to->oldest) = current;
+  to->newest = current;
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::detach_(slot* current) {
+  entry& linked = current->second;
+  (linked.older ? linked.older->second.newer : linked.bucket_->oldest) = linked.newer;
+  (linked.newer ? linked.newer->second.older : linked.bucket_->newest) = linked.older;
+  linked.older = nullptr;
+  linked.newer = nullptr;
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::touch_(slot* current) {
+  auto from = current->second.bucket_;
+  auto to = from;
+  if constexpr (frequency_) {
+    to = std::next(from);
+    if (to == buckets_.end() || to->uses != from->uses + 1) {
+      to = buckets_.insert(to, bucket{from->uses + 1});
+    }
+  } else if (from->newest == current) {
+    return;
+  }
+  detach_(current);
+  attach_(current, to);
+  if (!from->oldest) buckets_.erase(from);
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::evict_() {
+  auto victims = buckets_.begin();
+  slot* victim = victims->oldest;
+  detach_(victim);
+  if (!victims->oldest) buckets_.erase(victims);
+  this->unlink_(this->find_(this->root_, victim->first));
+  ++stats_.evictions;
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::insert(const value_type& value) {
+  if (Node* found = this->find_(this->root_, value.first)) {
+    found->value.second.value = value.second;
+    touch_(&found->value);
+    return;
+  }
+  base::upsert(value.first, [&value](entry& current) { current.value = value.second; });
+  // the new element joins the list only after the eviction, so it is never its own victim
+  slot* inserted = &this->last_->value;
+  if (this->size_ > capacity_) evict_();
+  constexpr size_t first_use = frequency_ ? 1 : 0;
+  if (buckets_.empty() || buckets_.front().uses != first_use) {
+    buckets_.push_front(bucket{first_use});
+  }
+  attach_(inserted, buckets_.begin());
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+  for (const auto& item : initializer_list) {
+    insert(item);
+  }
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::iterator bst_cache<Key,
+                                                                               Value,
+                                                                               Eviction,
+                                                                               Traversal,
+                                                                               Compare,
+                                                                               Alloc>::find(const key_type& key) {
+  Node* found = this->find_(this->root_, key);
+  if (!found) {
+    ++stats_.misses;
+    return iterator(nullptr);
+  }
+  ++stats_.hits;
+  touch_(&found->value);
+  return iterator(found);
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+size_t bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::erase(const key_type& key) {
+  Node* found = this->find_(this->root_, key);
+  if (!found) {
+    return 0;
+  }
+  auto from = found->value.second.bucket_;
+  detach_(&found->value);
+  if (!from->oldest) buckets_.erase(from);
+  this->unlink_(found);
+  return 1;
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::clear() {
+  base::clear();
+  buckets_.clear();
+}
+
+template<class Key, class Value, class Eviction, class Traversal, class Compare, class Alloc>
+void bst_cache<Key, Value, Eviction, Traversal, Compare, Alloc>::capacity(size_t capacity) {
+  capacity_ = std::max<size_t>(capacity, 1);
+  while (this->size_ > capacity_) {
+    evict_();
+  }
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <lib/iterator/bst_iterator.hpp>
+
+// bst with nodes in vector-backed pools: 32-bit child links, no parent links or visited flags
+// (the traversal stack lives in the iterator) and keys kept apart from values, so a search
+// touches only the keys_ and links_ arrays. Overhead per element is sizeof(Links) == 8 bytes.
+template<class Key, class Value, class Traversal = Preorder,
+    class Compare = std::less<Key>,
+    class Alloc = std::allocator<std::pair<Key, Value>>>
+class compact_bst {
+ public:
+  using index_type = std::uint32_t;
+  static constexpr index_type npos = std::numeric_limits<index_type>::max();
+
+ private:
+  struct Links {
+    index_type left = npos;
+    index_type right = npos;
+  };
+
+  template<class T>
+  using pool = std::vector<T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+  pool<Key> keys_;
+  pool<Value> values_;
+  pool<Links> links_;
+
+  index_type root_ = npos;
+  index_type free_ = npos;  // erased slots, chained through links_[i].left
+  size_t size_ = 0;
+
+  index_type allocate_(const std::pair<Key, Value>& value);
+  void release_(index_type index);
+
+ public:
+  template<bool Const>
+  class basic_iterator;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  using key_type = Key;
+  using mapped_type = Value;
+  using key_compare = Compare;
+  using size_type = std::size_t;
+  using value_type = std::pair<Key, Value>;
+  using allocator_type = Alloc;
+
+  compact_bst() noexcept = default;
+  compact_bst(std::initializer_list<value_type> initializer_list) { insert(initializer_list); }
+
+  void insert(const value_type& value);
+  void insert(std::initializer_list<value_type> initializer_list);
+
+  void extract(const key_type& key);
+
+  bool contains(const key_type& key) const { return find_(key) != npos; }
+  size_t count(const key_type& key) const { return contains(key); }
+
+  void reserve(size_t n);
+  void clear() noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  // slots held by the pools, erased ones waiting for reuse included
+  size_t slots() const noexcept { return links_.size(); }
+
+  iterator begin() { return iterator(this, root_); }
+  iterator end() { return iterator(this); }
+  const_iterator begin() const { return const_iterator(this, root_); }
+  const_iterator end() const { return const_iterator(this); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+ private:
+  index_type find_(const key_type& key) const;
+};
+
+// Const selects the tree and element constness; begin() const hands out const_iterator only
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+template<bool Const>
+class compact_bst<Key, Value, Traversal, Compare, Alloc>::basic_iterator {
+ private:
+  using tree_type = std::conditional_t<Const, const compact_bst, compact_bst>;
+  using mapped_reference = std::conditional_t<Const, const Value&, Value&>;
+
+  tree_type* tree_ = nullptr;
+  index_type current_ = npos;
+  // pending nodes (Preorder), unvisited ancestors (Inorder) or the path from the root (Postorder)
+  std::vector<index_type> stack_;
+
+  const Links& links_(index_type index) const { return tree_->links_[index]; }
+  void push_left_path_(index_type index);
+  void descend_postorder_(index_type index);
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::pair<const Key&, mapped_reference>;
+  using reference = value_type;
+  using traversal = Traversal;
+
+  basic_iterator() = default;
+  explicit basic_iterator(tree_type* tree) : tree_(tree) {}
+  basic_iterator(tree_type* tree, index_type root);
+
+  const Key& key() const noexcept { return tree_->keys_[current_]; }
+  mapped_reference value() const noexcept { return tree_->values_[current_]; }
+  reference operator*() const noexcept { return reference(key(), value()); }
+
+  basic_iterator& operator++();
+  basic_iterator operator++(int) {
+    basic_iterator tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  bool operator==(const basic_iterator& other) const noexcept { return current_ == other.current_; }
+  bool operator!=(const basic_iterator& other) const noexcept { return !(*this == other); }
+};
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+template<bool Const>
+compact_bst<Key, Value, Traversal, Compare, Alloc>::basic_iterator<Const>::basic_iterator(tree_type* tree, index_type root)
+    : tree_(tree) {
+  if (root == npos) {
+    return;
+  }
+  if constexpr (std::is_same_v<Traversal, Preorder>) {
+    current_ = root;
+  } else if constexpr (std::is_same_v<Traversal, Inorder>) {
+    push_left_path_(root);
+    current_ = stack_.back();
+    stack_.pop_back();
+  } else if constexpr (std::is_same_v<Traversal, Postorder>) {
+    descend_postorder_(root);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+template<bool Const>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::basic_iterator<Const>::push_left_path_(index_type index) {
+  for (; index != npos; index = links_(index).left) {
+    stack_.push_back(index);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+template<bool Const>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::basic_iterator<Const>::descend_postorder_(index_type index) {
+  while (true) {
+    if (links_(index).left != npos) {
+      stack_.push_back(index);
+      index = links_(index).left;
+    } else if (links_(index).right != npos) {
+      stack_.push_back(index);
+      index = links_(index).right;
+    } else {
+      current_ = index;
+      return;
+    }
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+template<bool Const>
+compact_bst<Key, Value, Traversal, Compare, Alloc>::basic_iterator<Const>& compact_bst<Key,
+                                                                                       Value,
+                                                                                       Traversal,
+                                                                                       Compare,
+                                                                                       Alloc>::basic_iterator<Const>::operator++() {
+  if (current_ == npos) {
+    throw std::out_of_range("Out of bounds.");
+  }
+  if constexpr (std::is_same_v<Traversal, Preorder>) {
+    if (links_(current_).right != npos) stack_.push_back(links_(current_).right);
+    if (links_(current_).left != npos) stack_.push_back(links_(current_).left);
+  } else if constexpr (std::is_same_v<Traversal, Inorder>) {
+    push_left_path_(links_(current_).right);
+  } else if constexpr (std::is_same_v<Traversal, Postorder>) {
+    if (!stack_.empty()) {
+      index_type parent = stack_.back();
+      if (links_(parent).left == current_ && links_(parent).right != npos) {
+        descend_postorder_(links_(parent).right);
+        return *this;
+      }
+    }
+  }
+  if (stack_.empty()) {
+    current_ = npos;
+  } else {
+    current_ = stack_.back();
+    stack_.pop_back();
+  }
+  return *this;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+compact_bst<Key, Value, Traversal, Compare, Alloc>::index_type compact_bst<Key,
+                                                                           Value,
+                                                                           Traversal,
+                                                                           Compare,
+                                                                           Alloc>::allocate_(const value_type& value) {
+  if (free_ != npos) {
+    index_type index = free_;
+    free_ = links_[index].left;
+    keys_[index] = value.first;
+    values_[index] = value.second;
+    links_[index] = Links{};
+    return index;
+  }
+  if (links_.size() == npos) {
+    throw std::length_error("compact_bst is limited to 2^32 - 1 nodes");
+  }
+  keys_.push_back(value.first);
+  values_.push_back(value.second);
+  links_.emplace_back();
+  return static_cast<index_type>(links_.size() - 1);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::release_(index_type index) {
+  links_[index].left = free_;
+  links_[index].right = npos;
+  free_ = index;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::insert(const value_type& value) {
+  // slots are addressed by index, not by pointer: allocate_ may grow the pools
+  index_type parent = npos;
+  bool left = false;
+  for (index_type current = root_; current != npos;) {
+    parent = current;
+    if (key_compare{}(value.first, keys_[current])) {
+      left = true;
+      current = links_[current].left;
+    } else if (key_compare{}(keys_[current], value.first)) {
+      left = false;
+      current = links_[current].right;
+    } else {
+      if (value.second < values_[current]) {
+        values_[current] = value.second;
+      }
+      return;
+    }
+  }
+  index_type index = allocate_(value);
+  if (parent == npos) {
+    root_ = index;
+  } else if (left) {
+    links_[parent].left = index;
+  } else {
+    links_[parent].right = index;
+  }
+  ++size_;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+  for (const auto& item : initializer_list) {
+    insert(item);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::extract(const key_type& key) {
+  index_type* link = &root_;
+  while (*link != npos) {
+    if (key_compare{}(key, keys_[*link])) {
+      link = &links_[*link].left;
+    } else if (key_compare{}(keys_[*link], key)) {
+      link = &links_[*link].right;
+    } else {
+      break;
+    }
+  }
+  if (*link == npos) {
+    return;
+  }
+
+  index_type current = *link;
+  if (links_[current].left == npos) {
+    *link = links_[current].right;
+  } else if (links_[current].right == npos) {
+    *link = links_[current].left;
+  } else {
+    index_type* successor = &links_[current].right;
+    while (links_[*successor].left != npos) {
+      successor = &links_[*successor].left;
+    }
+    index_type next = *successor;
+    keys_[current] = std::move(keys_[next]);
+    values_[current] = std::move(values_[next]);
+    *successor = links_[next].right;
+    current = next;
+  }
+  release_(current);
+  --size_;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+compact_bst<Key, Value, Traversal, Compare, Alloc>::index_type compact_bst<Key,
+                                                                           Value,
+                                                                           Traversal,
+                                                                           Compare,
+                                                                           Alloc>::find_(const key_type& key) const {
+  index_type current = root_;
+  while (current != npos) {
+    if (key_compare{}(key, keys_[current])) {
+      current = links_[current].left;
+    } else if (key_compare{}(keys_[current], key)) {
+      current = links_[current].right;
+    } else {
+      break;
+    }
+  }
+  return current;
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::reserve(size_t n) {
+  keys_.reserve(n);
+  values_.reserve(n);
+  links_.reserve(n);
+}
+
+template<class Key, class Value, class Traversal, class Compare, class Alloc>
+void compact_bst<Key, Value, Traversal, Compare, Alloc>::clear() noexcept {
+  keys_.clear();
+  values_.clear();
+  links_.clear();
+  root_ = npos;
+  free_ = npos;
+  size_ = 0;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <lib/bst.hpp>
+
+// bst with a side open-addressing index from key to Node*: contains/find/count and duplicate
+// resolution on insert are O(1) expected, ordered iteration and aggregates still use the tree.
+// Nodes are only ever relinked, never copied into one another, so index entries stay valid.
+template<class Key, class Value, class Traversal = Preorder,
+    class Hash = std::hash<Key>,
+    class Compare = std::less<Key>,
+    class Alloc = std::allocator<std::pair<Key, Value>>>
+class hashed_bst : protected bst<Key, Value, Traversal, Compare, Alloc> {
+ private:
+  using base = bst<Key, Value, Traversal, Compare, Alloc>;
+  using Node = base::Node;
+  using slot_allocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Node*>;
+
+  // linear probing with backward-shift deletion, no tombstones; capacity is a power of two
+  std::vector<Node*, slot_allocator> slots_;
+  int shift_ = 64;
+  float max_load_factor_ = 0.5f;
+
+  size_t home_(const Key& key) const {
+    return static_cast<size_t>((static_cast<std::uint64_t>(Hash{}(key)) * 11400714819323198485ull) >> shift_);
+  }
+  static bool equal_(const Key& lhs, const Key& rhs) { return !Compare{}(lhs, rhs) && !Compare{}(rhs, lhs); }
+  size_t mask_() const { return slots_.size() - 1; }
+
+  size_t probe_(const Key& key) const;
+  void index_(Node* current);
+  void unindex_(const Key& key);
+  void rehash_(size_t capacity);
+  void reindex_();
+
+ public:
+  using typename base::iterator;
+  using typename base::key_type;
+  using typename base::mapped_type;
+  using typename base::value_type;
+  using typename base::size_type;
+
+  hashed_bst() = default;
+  explicit hashed_bst(float max_load_factor) { this->max_load_factor(max_load_factor); }
+  hashed_bst(std::initializer_list<value_type> initializer_list) { insert(initializer_list); }
+  hashed_bst(const hashed_bst& other) : base(other), max_load_factor_(other.max_load_factor_) { reindex_(); }
+  hashed_bst& operator=(const hashed_bst&) = delete;
+
+  using base::begin;
+  using base::end;
+  using base::cbegin;
+  using base::cend;
+  using base::size;
+  using base::equal_range;
+  using base::operator[];
+
+  void insert(const value_type& value);
+  void insert(std::initializer_list<value_type> initializer_list);
+
+  void extract(const key_type& key) { erase(key); }
+  size_t erase(const key_type& key);
+  iterator erase(iterator p);
+  template<class Predicate>
+  size_t erase_if(Predicate pred);
+
+  void clear();
+
+  bool contains(const key_type& key) const { return slots_.size() && slots_[probe_(key)]; }
+  size_t count(const key_type& key) const { return contains(key); }
+  iterator find(const key_type& key) const { return iterator(slots_.size() ? slots_[probe_(key)] : nullptr); }
+
+  // index memory is bucket_count() * sizeof(Node*) bytes; a lower load factor trades it for shorter probes
+  float max_load_factor() const noexcept { return max_load_factor_; }
+  void max_load_factor(float load_factor);
+  float load_factor() const noexcept { return slots_.empty() ? 0.0f : static_cast<float>(this->size_) / slots_.size(); }
+  size_t bucket_count() const noexcept { return slots_.size(); }
+  size_t index_memory() const noexcept { return slots_.capacity() * sizeof(Node*); }
+};
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+size_t hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::probe_(const Key& key) const {
+  size_t slot = home_(key);
+  while (slots_[slot] && !equal_(slots_[slot]->value.first, key)) {
+    slot = (slot + 1) & mask_();
+  }
+  return slot;
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::index_(Node* current) {
+  if (static_cast<float>(this->size_) > max_load_factor_ * slots_.size()) {
+    rehash_(std::max<size_t>(slots_.size() * 2, 8));
+  }
+  slots_[probe_(current->value.first)] = current;
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::unindex_(const Key& key) {
+  size_t hole = probe_(key);
+  slots_[hole] = nullptr;
+  // pull back every later entry of the cluster whose home is not between the hole and itself
+  for (size_t slot = (hole + 1) & mask_(); slots_[slot]; slot = (slot + 1) & mask_()) {
+    size_t home = home_(slots_[slot]->value.first);
+    if (((slot - home) & mask_()) >= ((slot - hole) & mask_())) {
+      slots_[hole] = slots_[slot];
+      slots_[slot] = nullptr;
+      hole = slot;
+    }
+  }
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::rehash_(size_t capacity) {
+  std::vector<Node*, slot_allocator> old(capacity, nullptr);
+  old.swap(slots_);
+  shift_ = 64 - std::countr_zero(capacity);
+  for (Node* current : old) {
+    if (current) slots_[probe_(current->value.first)] = current;
+  }
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::reindex_() {
+  size_t capacity = 8;
+  while (static_cast<float>(this->size_) > max_load_factor_ * capacity) capacity *= 2;
+  slots_.assign(capacity, nullptr);
+  shift_ = 64 - std::countr_zero(capacity);
+  for (Node* current = this->get_min_(this->root_); current; current = base::next_inorder_(current)) {
+    slots_[probe_(current->value.first)] = current;
+  }
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::max_load_factor(float load_factor) {
+  max_load_factor_ = std::clamp(load_factor, 0.1f, 0.95f);
+  reindex_();
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::insert(const value_type& value) {
+  if (Node* found = find(value.first).base()) {
+    keep_min::resolve(found->value.second, value.second);
+    return;
+  }
+  base::insert(value);
+  index_(this->last_);
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+  for (const auto& item : initializer_list) {
+    insert(item);
+  }
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+size_t hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::erase(const key_type& key) {
+  Node* found = find(key).base();
+  if (!found) {
+    return 0;
+  }
+  unindex_(key);
+  this->unlink_(found);
+  return 1;
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::iterator hashed_bst<Key,
+                                                                             Value,
+                                                                             Traversal,
+                                                                             Hash,
+                                                                             Compare,
+                                                                             Alloc>::erase(iterator p) {
+  unindex_((*p).value.first);
+  return base::erase(p);
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+template<class Predicate>
+size_t hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::erase_if(Predicate pred) {
+  size_t erased = base::erase_if(pred);
+  reindex_();
+  return erased;
+}
+
+template<class Key, class Value, class Traversal, class Hash, class Compare, class Alloc>
+void hashed_bst<Key, Value, Traversal, Hash, Compare, Alloc>::clear() {
+  base::clear();
+  std::fill(slots_.begin(), slots_.end(), nullptr);
+}
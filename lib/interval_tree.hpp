@@ -0,0 +1,68 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <lib/bst.hpp>
+
+// Augment of interval_tree: the greatest right endpoint in a subtree
+template<class T>
+struct max_endpoint {
+  using value_type = T;
+  static constexpr value_type identity() noexcept { return std::numeric_limits<value_type>::lowest(); }
+  static constexpr value_type combine(const value_type& lhs, const value_type& rhs) { return lhs < rhs ? rhs : lhs; }
+  template<class Value>
+  static constexpr value_type lift(const std::pair<T, T>& key, const Value&) { return key.second; }
+};
+
+// bst keyed by closed intervals [lo, hi] ordered by lo (then hi)
+template<class T, class Value, class Traversal = Preorder,
+    class Alloc = std::allocator<std::pair<std::pair<T, T>, Value>>>
+class interval_tree : public bst<std::pair<T, T>, Value, Traversal, std::less<std::pair<T, T>>, Alloc, max_endpoint<T>> {
+ private:
+  using base = bst<std::pair<T, T>, Value, Traversal, std::less<std::pair<T, T>>, Alloc, max_endpoint<T>>;
+  using Node = base::Node;
+
+  template<class F>
+  static void overlapping_(Node* current, const std::pair<T, T>& interval, F& visit);
+ public:
+  using interval_type = std::pair<T, T>;
+  using iterator = base::iterator;
+  using value_type = base::value_type;
+
+  using base::base;
+
+  // All stored intervals intersecting the query, in key order, O(log n + k) on a shallow tree
+  std::vector<iterator> overlapping(const T& point) const { return overlapping(interval_type(point, point)); }
+  std::vector<iterator> overlapping(const interval_type& interval) const;
+
+  template<class F>
+  void for_each_overlapping(const interval_type& interval, F visit) const { overlapping_(this->root_, interval, visit); }
+};
+
+template<class T, class Value, class Traversal, class Alloc>
+template<class F>
+void interval_tree<T, Value, Traversal, Alloc>::overlapping_(Node* current, const interval_type& interval, F& visit) {
+  // a subtree whose greatest hi is left of the query cannot overlap it
+  if (!current || current->aggregate < interval.first) {
+    return;
+  }
+  overlapping_(current->left, interval, visit);
+  if (interval.second < current->value.first.first) {
+    return;
+  }
+  if (!(current->value.first.second < interval.first)) {
+    visit(iterator(current));
+  }
+  overlapping_(current->right, interval, visit);
+}
+
+template<class T, class Value, class Traversal, class Alloc>
+std::vector<typename interval_tree<T, Value, Traversal, Alloc>::iterator> interval_tree<T,
+                                                                                       Value,
+                                                                                       Traversal,
+                                                                                       Alloc>::overlapping(const interval_type& interval) const {
+  std::vector<iterator> result;
+  for_each_overlapping(interval, [&result](iterator it) { result.push_back(it); });
+  return result;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include <lib/iterator/bst_iterator.hpp>
+
+// Links embedded in the user's type: struct job : bst_hook<job> { ... }. They carry the same
+// fields as bst's nodes, so bst_iterator walks user objects directly. Objects compare equal
+// only to themselves unless T defines its own operator==.
+template<class T>
+struct bst_hook {
+  T* left = nullptr;
+  T* right = nullptr;
+  T* parent = nullptr;
+  bool visited = false;
+
+  friend bool operator==(const bst_hook& lhs, const bst_hook& rhs) noexcept { return &lhs == &rhs; }
+};
+
+// bst over objects owned elsewhere: insert and extract only relink hooks, nothing is allocated
+// or copied. KeyOf{}(const T&) yields the key. An object is in at most one tree at a time and
+// must outlive its membership; the tree unlinks whatever it still holds when destroyed.
+template<class T, class KeyOf, class Traversal = Preorder, class Compare = std::less<>>
+class intrusive_bst {
+ private:
+  T* root_ = nullptr;
+  T* last_ = nullptr;
+  size_t size_ = 0;
+
+  static decltype(auto) key_(const T& item) { return KeyOf{}(item); }
+  static T* get_min_(T* current);
+  static T* get_max_(T* current);
+  static void reset_(T* current);
+  T* find_(const auto& key) const;
+  T* join_(T* left, T* right);
+
+ public:
+  using value_type = T;
+  using key_compare = Compare;
+  using size_type = std::size_t;
+  using iterator = bst_iterator<T, Traversal>;
+
+  intrusive_bst() noexcept = default;
+  intrusive_bst(const intrusive_bst&) = delete;
+  intrusive_bst& operator=(const intrusive_bst&) = delete;
+  ~intrusive_bst() { clear(); }
+
+  // false, leaving item unlinked, if an element with the same key is already linked
+  bool insert(T& item);
+  // unlinks item, which must be in this tree
+  void erase(T& item);
+  // unlinks and returns the element with key, nullptr if there is none
+  T* extract(const auto& key);
+
+  bool contains(const auto& key) const { return find_(key) != nullptr; }
+  iterator find(const auto& key) const { return iterator(find_(key)); }
+
+  // unlinks every element, O(n)
+  void clear() noexcept;
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  iterator begin() const { return iterator(root_); }
+  iterator end() const { return iterator(last_); }
+};
+
+template<class T, class KeyOf, class Traversal, class Compare>
+T* intrusive_bst<T, KeyOf, Traversal, Compare>::get_min_(T* current) {
+  while (current && current->left) current = current->left;
+  return current;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+T* intrusive_bst<T, KeyOf, Traversal, Compare>::get_max_(T* current) {
+  while (current && current->right) current = current->right;
+  return current;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+void intrusive_bst<T, KeyOf, Traversal, Compare>::reset_(T* current) {
+  current->left = nullptr;
+  current->right = nullptr;
+  current->parent = nullptr;
+  current->visited = false;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+T* intrusive_bst<T, KeyOf, Traversal, Compare>::find_(const auto& key) const {
+  T* current = root_;
+  while (current) {
+    if (key_compare{}(key, key_(*current))) {
+      current = current->left;
+    } else if (key_compare{}(key_(*current), key)) {
+      current = current->right;
+    } else {
+      break;
+    }
+  }
+  return current;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+bool intrusive_bst<T, KeyOf, Traversal, Compare>::insert(T& item) {
+  T* parent = nullptr;
+  T** link = &root_;
+  while (*link) {
+    parent = *link;
+    if (key_compare{}(key_(item), key_(*parent))) {
+      link = &parent->left;
+    } else if (key_compare{}(key_(*parent), key_(item))) {
+      link = &parent->right;
+    } else {
+      return false;
+    }
+  }
+  reset_(&item);
+  item.parent = parent;
+  *link = &item;
+  last_ = &item;
+  ++size_;
+  return true;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+T* intrusive_bst<T, KeyOf, Traversal, Compare>::join_(T* left, T* right) {
+  // every key of left is below every key of right; the minimum of right becomes the common root
+  if (!left || !right) {
+    return left ? left : right;
+  }
+  T* top = get_min_(right);
+  if (top != right) {
+    top->parent->left = top->right;
+    if (top->right) top->right->parent = top->parent;
+    top->right = right;
+    right->parent = top;
+  }
+  top->left = left;
+  left->parent = top;
+  return top;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+void intrusive_bst<T, KeyOf, Traversal, Compare>::erase(T& item) {
+  T* parent = item.parent;
+  T* replacement = join_(item.left, item.right);
+  if (!parent) {
+    root_ = replacement;
+  } else if (parent->left == &item) {
+    parent->left = replacement;
+  } else {
+    parent->right = replacement;
+  }
+  if (replacement) replacement->parent = parent;
+  reset_(&item);
+  --size_;
+  if (last_ == &item) last_ = get_max_(root_);
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+T* intrusive_bst<T, KeyOf, Traversal, Compare>::extract(const auto& key) {
+  T* found = find_(key);
+  if (found) erase(*found);
+  return found;
+}
+
+template<class T, class KeyOf, class Traversal, class Compare>
+void intrusive_bst<T, KeyOf, Traversal, Compare>::clear() noexcept {
+  // iterative post-order, the same walk as bst::release_ without the deallocation
+  T* current = root_;
+  while (current) {
+    if (current->left) {
+      current = current->left;
+    } else if (current->right) {
+      current = current->right;
+    } else {
+      T* parent = current->parent;
+      if (parent) {
+        (parent->left == current ? parent->left : parent->right) = nullptr;
+      }
+      reset_(current);
+      current = parent;
+    }
+  }
+  root_ = nullptr;
+  last_ = nullptr;
+  size_ = 0;
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// Lazily produced sequence of T&, backed by a coroutine frame that holds the scan position.
+// An element is pending from the moment it is yielded until it is consumed by ++ or a step
+// call, so a scan left through break, or sliced with step/step_for, resumes exactly where it
+// stopped. The producer is never resumed past the element in hand, so erasing that element
+// before moving on is not allowed.
+template<class T>
+class bst_generator {
+ public:
+  struct promise_type {
+    T* current = nullptr;
+    std::exception_ptr exception;
+
+    bst_generator get_return_object() noexcept {
+      return bst_generator(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_always final_suspend() const noexcept { return {}; }
+    std::suspend_always yield_value(T& value) noexcept {
+      current = std::addressof(value);
+      return {};
+    }
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+  };
+
+  class iterator;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  bst_generator() noexcept = default;
+  bst_generator(bst_generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  bst_generator& operator=(bst_generator&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~bst_generator() {
+    if (handle_) handle_.destroy();
+  }
+
+  // resumes the producer only if no element is pending
+  iterator begin();
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+  // Consumes up to n elements with fn, or the elements produced within budget (checked after
+  // each one, so at least one is consumed). True while the scan has more elements.
+  template<class F>
+  bool step(size_t n, F&& fn);
+  template<class Rep, class Period, class F>
+  bool step_for(std::chrono::duration<Rep, Period> budget, F&& fn);
+
+  bool done() const noexcept { return !handle_ || (handle_.done() && !handle_.promise().current); }
+
+ private:
+  handle_type handle_;
+
+  explicit bst_generator(handle_type handle) noexcept : handle_(handle) {}
+  T* pending_();
+  void consume_() noexcept { handle_.promise().current = nullptr; }
+};
+
+template<class T>
+class bst_generator<T>::iterator {
+ private:
+  bst_generator* generator_ = nullptr;
+
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::remove_cv_t<T>;
+  using reference = T&;
+  using pointer = T*;
+
+  iterator() = default;
+  explicit iterator(bst_generator* generator) : generator_(generator) {}
+
+  reference operator*() const noexcept { return *generator_->handle_.promise().current; }
+  pointer operator->() const noexcept { return generator_->handle_.promise().current; }
+
+  iterator& operator++() {
+    generator_->consume_();
+    generator_->pending_();
+    return *this;
+  }
+  void operator++(int) { ++*this; }
+
+  bool operator==(std::default_sentinel_t) const noexcept { return !generator_ || generator_->done(); }
+};
+
+template<class T>
+T* bst_generator<T>::pending_() {
+  if (!handle_ || handle_.done() || handle_.promise().current) {
+    return handle_ ? handle_.promise().current : nullptr;
+  }
+  handle_.resume();
+  if (handle_.promise().exception) {
+    std::rethrow_exception(std::exchange(handle_.promise().exception, nullptr));
+  }
+  return handle_.promise().current;
+}
+
+template<class T>
+bst_generator<T>::iterator bst_generator<T>::begin() {
+  pending_();
+  return iterator(this);
+}
+
+template<class T>
+template<class F>
+bool bst_generator<T>::step(size_t n, F&& fn) {
+  for (; n; --n) {
+    T* current = pending_();
+    if (!current) return false;
+    fn(*current);
+    consume_();
+  }
+  return pending_() != nullptr;
+}
+
+template<class T>
+template<class Rep, class Period, class F>
+bool bst_generator<T>::step_for(std::chrono::duration<Rep, Period> budget, F&& fn) {
+  auto deadline = std::chrono::steady_clock::now() + budget;
+  while (T* current = pending_()) {
+    fn(*current);
+    consume_();
+    if (std::chrono::steady_clock::now() >= deadline) break;
+  }
+  return pending_() != nullptr;
+}
+
+// Awaitable form of bst_generator for consumers that are coroutines themselves:
+// `while (auto* value = co_await scan.next())` transfers control straight to the producer and
+// back without going through a scheduler, so the consumer decides where to yield to its event
+// loop, e.g. every K elements.
+template<class T>
+class bst_async_generator {
+ public:
+  struct promise_type;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  // hands control back to whoever awaited next()
+  struct transfer {
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(handle_type producer) const noexcept { return producer.promise().consumer; }
+    void await_resume() const noexcept {}
+  };
+
+  struct promise_type {
+    T* current = nullptr;
+    std::coroutine_handle<> consumer;
+    std::exception_ptr exception;
+
+    bst_async_generator get_return_object() noexcept { return bst_async_generator(handle_type::from_promise(*this)); }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    transfer final_suspend() const noexcept { return {}; }
+    transfer yield_value(T& value) noexcept {
+      current = std::addressof(value);
+      return {};
+    }
+    void return_void() noexcept { current = nullptr; }
+    void unhandled_exception() noexcept {
+      current = nullptr;
+      exception = std::current_exception();
+    }
+  };
+
+  class next_awaiter;
+
+  bst_async_generator() noexcept = default;
+  bst_async_generator(bst_async_generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  bst_async_generator& operator=(bst_async_generator&& other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+  ~bst_async_generator() {
+    if (handle_) handle_.destroy();
+  }
+
+  // co_await yields a pointer to the next element, nullptr once the scan is over
+  next_awaiter next() noexcept { return next_awaiter(handle_); }
+
+ private:
+  handle_type handle_;
+
+  explicit bst_async_generator(handle_type handle) noexcept : handle_(handle) {}
+};
+
+template<class T>
+class bst_async_generator<T>::next_awaiter {
+ private:
+  handle_type producer_;
+
+ public:
+  explicit next_awaiter(handle_type producer) noexcept : producer_(producer) {}
+
+  bool await_ready() const noexcept { return !producer_ || producer_.done(); }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept {
+    producer_.promise().consumer = consumer;
+    return producer_;
+  }
+  T* await_resume() const {
+    if (!producer_) return nullptr;
+    if (producer_.promise().exception) {
+      std::rethrow_exception(std::exchange(producer_.promise().exception, nullptr));
+    }
+    return producer_.done() ? nullptr : producer_.promise().current;
+  }
+};
@@ -29,7 +29,8 @@ class bst_iterator {
   ~bst_iterator() noexcept = default;
 
   reference operator*() const noexcept;
-  reference operator->() const noexcept;
+  pointer operator->() const noexcept;
+  pointer base() const noexcept;
 
   bst_iterator& operator++() noexcept;
   const bst_iterator operator++(int) noexcept;
@@ -64,7 +65,12 @@ inline bst_iterator<T, Tag>::reference bst_iterator<T, Tag>::operator*() const n
 }
 
 template<class T, typename Tag>
-inline T& bst_iterator<T, Tag>::operator->() const noexcept {
+inline T* bst_iterator<T, Tag>::operator->() const noexcept {
+  return current;
+}
+
+template<class T, typename Tag>
+inline T* bst_iterator<T, Tag>::base() const noexcept {
   return current;
 }
 
@@ -231,6 +237,9 @@ inline bst_iterator<T, Tag> bst_iterator<T, Tag>::operator-=(int n) noexcept {
 
 template<class T, typename Tag>
 inline bool bst_iterator<T, Tag>::operator==(const bst_iterator& _x) const noexcept {
+  if (!current || !_x.current) {
+    return current == _x.current;
+  }
   return *current == *_x.current;
 }
 
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <lib/bst.hpp>
+
+// Write-optimized ordered map in two tiers. Inserts and extracts go into a bst memtable, an
+// extract leaving a tombstone (an empty optional). A full memtable is frozen into an immutable
+// sorted run; runs are kept newest first and a background thread merges a run into the next
+// older one once it is at least half that size, so there are O(log n) runs and each element
+// is rewritten O(log n) times. Tombstones are dropped when they reach the oldest run.
+// Lookups and scans consult the memtable, then the runs newest first; the newest entry wins.
+//
+// One thread may use the container at a time; only the merger runs alongside it.
+template<class Key, class Value,
+    class Compare = std::less<Key>,
+    class Alloc = std::allocator<std::pair<Key, Value>>>
+class lsm_bst : protected bst<Key, std::optional<Value>, Inorder, Compare,
+                              typename std::allocator_traits<Alloc>::template rebind_alloc<
+                                  std::pair<Key, std::optional<Value>>>,
+                              no_augment, plain_tree, overwrite> {
+ private:
+  using base = bst<Key, std::optional<Value>, Inorder, Compare,
+                   typename std::allocator_traits<Alloc>::template rebind_alloc<std::pair<Key, std::optional<Value>>>,
+                   no_augment, plain_tree, overwrite>;
+  using Node = base::Node;
+
+  template<class T>
+  using pool = std::vector<T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+  // keys apart from values, so a binary search touches only keys
+  struct run {
+    pool<Key> keys;
+    pool<std::optional<Value>> values;
+  };
+  using run_ptr = std::shared_ptr<const run>;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  size_t memtable_capacity_;
+  size_t max_runs_;
+
+  std::vector<run_ptr> runs_;  // newest first, guarded by mutex_
+  mutable std::mutex mutex_;
+  std::condition_variable merge_ready_;
+  std::condition_variable merge_done_;
+  bool merging_ = false;
+  bool stop_ = false;
+  std::thread merger_;
+
+  size_t pick_() const;
+  static run_ptr merge_(const run& newer, const run& older, bool oldest);
+  void merge_loop_();
+  std::vector<run_ptr> snapshot_() const;
+  Node* lower_bound_(const Key& key) const;
+
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key, Value>;
+  using size_type = std::size_t;
+  using key_compare = Compare;
+
+  // flush stalls while max_runs runs are waiting for the merger, bounding read amplification
+  explicit lsm_bst(size_t memtable_capacity = 4096, size_t max_runs = 16);
+  lsm_bst(std::initializer_list<value_type> initializer_list) : lsm_bst() { insert(initializer_list); }
+  lsm_bst(const lsm_bst&) = delete;
+  lsm_bst& operator=(const lsm_bst&) = delete;
+  ~lsm_bst();
+
+  // last writer wins; inserts use the memtable's finger, so ascending keys cost O(1) each
+  void insert(const value_type& value);
+  void insert(std::initializer_list<value_type> initializer_list);
+  void extract(const key_type& key);
+
+  std::optional<Value> find(const key_type& key) const;
+  bool contains(const key_type& key) const { return find(key).has_value(); }
+
+  // f(key, value) for every live element with lo <= key <= hi, in key order
+  template<class F>
+  void scan(const key_type& lo, const key_type& hi, F f) const;
+
+  // freezes the memtable into a run now
+  void flush();
+  // blocks until the merger has nothing left to do
+  void wait_for_merges();
+  void clear();
+
+  size_t memtable_size() const noexcept { return this->size_; }
+  size_t run_count() const;
+};
+
+template<class Key, class Value, class Compare, class Alloc>
+lsm_bst<Key, Value, Compare, Alloc>::lsm_bst(size_t memtable_capacity, size_t max_runs)
+    : memtable_capacity_(std::max<size_t>(memtable_capacity, 1)), max_runs_(std::max<size_t>(max_runs, 2)) {
+  merger_ = std::thread(&lsm_bst::merge_loop_, this);
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+lsm_bst<Key, Value, Compare, Alloc>::~lsm_bst() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  merge_ready_.notify_all();
+  merger_.join();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::insert(const value_type& value) {
+  base::insert(base::end(), {value.first, value.second});
+  if (this->size_ >= memtable_capacity_) flush();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+  for (const auto& item : initializer_list) {
+    insert(item);
+  }
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::extract(const key_type& key) {
+  base::insert(base::end(), {key, std::nullopt});
+  if (this->size_ >= memtable_capacity_) flush();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+std::optional<Value> lsm_bst<Key, Value, Compare, Alloc>::find(const key_type& key) const {
+  if (Node* found = this->find_(this->root_, key)) {
+    return found->value.second;
+  }
+  for (const run_ptr& current : snapshot_()) {
+    auto it = std::lower_bound(current->keys.begin(), current->keys.end(), key, key_compare{});
+    if (it != current->keys.end() && !key_compare{}(key, *it)) {
+      return current->values[it - current->keys.begin()];
+    }
+  }
+  return std::nullopt;
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+template<class F>
+void lsm_bst<Key, Value, Compare, Alloc>::scan(const key_type& lo, const key_type& hi, F f) const {
+  // k-way merge over the memtable and every run; among equal keys the newest source wins
+  std::vector<run_ptr> runs = snapshot_();
+  std::vector<size_t> cursors(runs.size());
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const auto& keys = runs[i]->keys;
+    cursors[i] = std::lower_bound(keys.begin(), keys.end(), lo, key_compare{}) - keys.begin();
+  }
+  Node* node = lower_bound_(lo);
+  while (true) {
+    const Key* least = node ? &node->value.first : nullptr;
+    for (size_t i = 0; i < runs.size(); ++i) {
+      if (cursors[i] < runs[i]->keys.size() && (!least || key_compare{}(runs[i]->keys[cursors[i]], *least))) {
+        least = &runs[i]->keys[cursors[i]];
+      }
+    }
+    if (!least || key_compare{}(hi, *least)) {
+      return;
+    }
+    Key key = *least;
+    const std::optional<Value>* newest = nullptr;
+    if (node && !key_compare{}(key, node->value.first)) {
+      newest = &node->value.second;
+      node = base::next_inorder_(node);
+    }
+    for (size_t i = 0; i < runs.size(); ++i) {
+      if (cursors[i] < runs[i]->keys.size() && !key_compare{}(key, runs[i]->keys[cursors[i]])) {
+        if (!newest) newest = &runs[i]->values[cursors[i]];
+        ++cursors[i];
+      }
+    }
+    if (newest->has_value()) {
+      f(key, **newest);
+    }
+  }
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::flush() {
+  if (!this->root_) {
+    return;
+  }
+  auto frozen = std::make_shared<run>();
+  frozen->keys.reserve(this->size_);
+  frozen->values.reserve(this->size_);
+  for (Node* current = base::get_min_(this->root_); current; current = base::next_inorder_(current)) {
+    frozen->keys.push_back(std::move(current->value.first));
+    frozen->values.push_back(std::move(current->value.second));
+  }
+  base::clear();
+
+  std::unique_lock lock(mutex_);
+  merge_done_.wait(lock, [this] { return runs_.size() < max_runs_; });
+  runs_.insert(runs_.begin(), std::move(frozen));
+  lock.unlock();
+  merge_ready_.notify_one();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::wait_for_merges() {
+  std::unique_lock lock(mutex_);
+  merge_done_.wait(lock, [this] { return !merging_ && pick_() == npos; });
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::clear() {
+  base::clear();
+  std::lock_guard lock(mutex_);
+  runs_.clear();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+size_t lsm_bst<Key, Value, Compare, Alloc>::run_count() const {
+  std::lock_guard lock(mutex_);
+  return runs_.size();
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+size_t lsm_bst<Key, Value, Compare, Alloc>::pick_() const {
+  // the oldest run that is at least half the size of its older neighbour, or with too many
+  // runs waiting the adjacent pair that is cheapest to merge
+  for (size_t i = runs_.size(); i-- > 1;) {
+    if (runs_[i - 1]->keys.size() * 2 >= runs_[i]->keys.size()) return i - 1;
+  }
+  if (runs_.size() < max_runs_) {
+    return npos;
+  }
+  size_t cheapest = 0;
+  for (size_t i = 1; i + 1 < runs_.size(); ++i) {
+    if (runs_[i]->keys.size() + runs_[i + 1]->keys.size()
+        < runs_[cheapest]->keys.size() + runs_[cheapest + 1]->keys.size()) {
+      cheapest = i;
+    }
+  }
+  return cheapest;
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+lsm_bst<Key, Value, Compare, Alloc>::run_ptr lsm_bst<Key, Value, Compare, Alloc>::merge_(const run& newer,
+                                                                                         const run& older,
+                                                                                         bool oldest) {
+  auto merged = std::make_shared<run>();
+  merged->keys.reserve(newer.keys.size() + older.keys.size());
+  merged->values.reserve(newer.keys.size() + older.keys.size());
+  auto append = [&merged, oldest](const Key& key, const std::optional<Value>& value) {
+    if (oldest && !value) return;
+    merged->keys.push_back(key);
+    merged->values.push_back(value);
+  };
+  size_t i = 0;
+  size_t j = 0;
+  while (i < newer.keys.size() || j < older.keys.size()) {
+    if (j == older.keys.size() || (i < newer.keys.size() && key_compare{}(newer.keys[i], older.keys[j]))) {
+      append(newer.keys[i], newer.values[i]);
+      ++i;
+    } else if (i == newer.keys.size() || key_compare{}(older.keys[j], newer.keys[i])) {
+      append(older.keys[j], older.values[j]);
+      ++j;
+    } else {
+      append(newer.keys[i], newer.values[i]);
+      ++i;
+      ++j;
+    }
+  }
+  return merged;
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+void lsm_bst<Key, Value, Compare, Alloc>::merge_loop_() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    merge_ready_.wait(lock, [this] { return stop_ || pick_() != npos; });
+    if (stop_) {
+      return;
+    }
+    size_t i = pick_();
+    run_ptr newer = runs_[i];
+    run_ptr older = runs_[i + 1];
+    bool oldest = i + 2 == runs_.size();
+    merging_ = true;
+    lock.unlock();
+    run_ptr merged = merge_(*newer, *older, oldest);
+    lock.lock();
+    merging_ = false;
+    // flush only adds runs in front and clear drops them all, so the pair is adjacent if present
+    auto it = std::find(runs_.begin(), runs_.end(), newer);
+    if (it != runs_.end() && std::next(it) != runs_.end() && *std::next(it) == older) {
+      it = runs_.erase(std::next(it));
+      if (merged->keys.empty()) {
+        runs_.erase(std::prev(it));
+      } else {
+        *std::prev(it) = std::move(merged);
+      }
+    }
+    merge_done_.notify_all();
+  }
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+std::vector<typename lsm_bst<Key, Value, Compare, Alloc>::run_ptr> lsm_bst<Key, Value, Compare, Alloc>::snapshot_() const {
+  std::lock_guard lock(mutex_);
+  return runs_;
+}
+
+template<class Key, class Value, class Compare, class Alloc>
+lsm_bst<Key, Value, Compare, Alloc>::Node* lsm_bst<Key, Value, Compare, Alloc>::lower_bound_(const Key& key) const {
+  Node* bound = nullptr;
+  for (Node* current = this->root_; current;) {
+    if (key_compare{}(current->value.first, key)) {
+      current = current->right;
+    } else {
+      bound = current;
+      current = current->left;
+    }
+  }
+  return bound;
+}
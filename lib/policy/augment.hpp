@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+// An augmentation is a monoid cached by every node for its whole subtree:
+//   value_type - type of the cached value
+//   identity() - neutral element
+//   combine(a, b) - associative operation, a is on the left of b in key order
+//   lift(key, value) - value contributed by a single element
+
+struct no_augment {
+  using value_type = void;
+};
+
+template<class T>
+struct sum_of {
+  using value_type = T;
+  static constexpr value_type identity() noexcept { return value_type{}; }
+  static constexpr value_type combine(const value_type& lhs, const value_type& rhs) { return lhs + rhs; }
+  template<class Key, class Value>
+  static constexpr value_type lift(const Key&, const Value& value) { return value; }
+};
+
+template<class T>
+struct min_of {
+  using value_type = T;
+  static constexpr value_type identity() noexcept { return std::numeric_limits<value_type>::max(); }
+  static constexpr value_type combine(const value_type& lhs, const value_type& rhs) { return rhs < lhs ? rhs : lhs; }
+  template<class Key, class Value>
+  static constexpr value_type lift(const Key&, const Value& value) { return value; }
+};
+
+template<class T>
+struct max_of {
+  using value_type = T;
+  static constexpr value_type identity() noexcept { return std::numeric_limits<value_type>::lowest(); }
+  static constexpr value_type combine(const value_type& lhs, const value_type& rhs) { return lhs < rhs ? rhs : lhs; }
+  template<class Key, class Value>
+  static constexpr value_type lift(const Key&, const Value& value) { return value; }
+};
+
+template<class T = std::size_t>
+struct count_of {
+  using value_type = T;
+  static constexpr value_type identity() noexcept { return value_type{}; }
+  static constexpr value_type combine(const value_type& lhs, const value_type& rhs) { return lhs + rhs; }
+  template<class Key, class Value>
+  static constexpr value_type lift(const Key&, const Value&) { return value_type{1}; }
+};
+
+template<class Augment>
+struct augment_node {
+  typename Augment::value_type aggregate = Augment::identity();
+};
+
+template<>
+struct augment_node<no_augment> {};
@@ -0,0 +1,13 @@
+#pragma once
+
+// Restructuring applied by bst after a successful lookup
+
+// the shape depends on insertion order only
+struct plain_tree {};
+
+// the accessed node is rotated all the way up to the root
+struct splay_tree {};
+
+// zig-zig steps rotate the parent only and continue from it, so the accessed
+// node is roughly halved in depth with about half the rotations of splay_tree
+struct semi_splay_tree {};
@@ -0,0 +1,34 @@
+#pragma once
+
+// What bst::insert does with a key that is already present:
+// resolve(current, incoming) updates the stored value in place
+
+// keep the smaller of the two values
+struct keep_min {
+  template<class Value>
+  static void resolve(Value& current, const Value& incoming) {
+    if (incoming < current) current = incoming;
+  }
+};
+
+// keep the value inserted first
+struct keep_first {
+  template<class Value>
+  static void resolve(Value&, const Value&) {}
+};
+
+// last writer wins
+struct overwrite {
+  template<class Value>
+  static void resolve(Value& current, const Value& incoming) { current = incoming; }
+};
+
+// current = Fn{}(current, incoming), e.g. combine<std::plus<>> for counters
+template<class Fn>
+struct combine {
+  template<class Value>
+  static void resolve(Value& current, const Value& incoming) { current = Fn{}(current, incoming); }
+};
+
+// keep both elements; equal keys stay in insertion order
+struct keep_all {};
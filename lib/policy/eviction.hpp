@@ -0,0 +1,9 @@
+#pragma once
+
+// Which element bst_cache drops when an insert goes past its capacity
+
+// the element touched least recently
+struct lru {};
+
+// the element touched the fewest times, the least recently touched of those on a tie
+struct lfu {};
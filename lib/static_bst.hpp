@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include <lib/iterator/bst_iterator.hpp>
+
+// Immutable bst over a key set known at compile time. The elements are stored in one array in
+// Eytzinger order (the children of slot k are 2k + 1 and 2k + 2), which is a complete, hence
+// balanced, tree: no heap, no pointers, and an iterator is a single index. Built by
+// make_static_bst in a constexpr context; duplicate keys fail to compile.
+template<class Key, class Value, std::size_t N, class Traversal = Preorder, class Compare = std::less<Key>>
+class static_bst {
+ public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<Key, Value>;
+  using size_type = std::size_t;
+  using key_compare = Compare;
+
+  class iterator;
+
+  constexpr explicit static_bst(std::array<value_type, N> items);
+
+  constexpr bool contains(const key_type& key) const { return locate_(key) != N; }
+  constexpr iterator find(const key_type& key) const { return iterator(this, locate_(key)); }
+  // the element with the smallest key not less than key, end() if there is none
+  constexpr iterator lower_bound(const key_type& key) const;
+
+  constexpr size_t size() const noexcept { return N; }
+  constexpr bool empty() const noexcept { return N == 0; }
+
+  constexpr iterator begin() const { return iterator(this, iterator::first_(0)); }
+  constexpr iterator end() const { return iterator(this, N); }
+
+ private:
+  std::array<value_type, N> nodes_{};
+
+  constexpr void fill_(const std::array<value_type, N>& sorted, size_t& next, size_t slot);
+  constexpr size_t locate_(const key_type& key) const;
+};
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+class static_bst<Key, Value, N, Traversal, Compare>::iterator {
+ private:
+  const static_bst* tree_ = nullptr;
+  size_t slot_ = N;
+
+  static constexpr size_t left_(size_t slot) { return 2 * slot + 1; }
+  static constexpr size_t right_(size_t slot) { return 2 * slot + 2; }
+  static constexpr size_t parent_(size_t slot) { return (slot - 1) / 2; }
+  // first slot of the subtree at slot in Traversal order
+  static constexpr size_t first_(size_t slot);
+  friend class static_bst;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = static_bst::value_type;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using traversal = Traversal;
+
+  constexpr iterator() = default;
+  constexpr iterator(const static_bst* tree, size_t slot) : tree_(tree), slot_(slot) {}
+
+  constexpr reference operator*() const { return tree_->nodes_[slot_]; }
+  constexpr pointer operator->() const { return &tree_->nodes_[slot_]; }
+
+  constexpr iterator& operator++();
+  constexpr iterator operator++(int) {
+    iterator tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  constexpr bool operator==(const iterator& other) const noexcept { return slot_ == other.slot_; }
+  constexpr bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+};
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr size_t static_bst<Key, Value, N, Traversal, Compare>::iterator::first_(size_t slot) {
+  if (slot >= N || std::is_same_v<Traversal, Preorder>) {
+    return slot;
+  }
+  // in a complete tree a right child exists only next to a left one
+  while (left_(slot) < N) {
+    slot = left_(slot);
+  }
+  return slot;
+}
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr static_bst<Key, Value, N, Traversal, Compare>::iterator& static_bst<Key,
+                                                                             Value,
+                                                                             N,
+                                                                             Traversal,
+                                                                             Compare>::iterator::operator++() {
+  size_t slot = slot_;
+  if constexpr (std::is_same_v<Traversal, Preorder>) {
+    if (left_(slot) < N) {
+      slot_ = left_(slot);
+      return *this;
+    }
+    while (slot != 0 && (slot == right_(parent_(slot)) || right_(parent_(slot)) >= N)) {
+      slot = parent_(slot);
+    }
+    slot_ = slot == 0 ? N : right_(parent_(slot));
+  } else if constexpr (std::is_same_v<Traversal, Inorder>) {
+    if (right_(slot) < N) {
+      slot_ = first_(right_(slot));
+      return *this;
+    }
+    while (slot != 0 && slot == right_(parent_(slot))) {
+      slot = parent_(slot);
+    }
+    slot_ = slot == 0 ? N : parent_(slot);
+  } else if constexpr (std::is_same_v<Traversal, Postorder>) {
+    if (slot == 0) {
+      slot_ = N;
+    } else if (slot == left_(parent_(slot)) && right_(parent_(slot)) < N) {
+      // the leftmost leaf of the right sibling, first_ stops at the deepest left descendant
+      slot_ = first_(right_(parent_(slot)));
+    } else {
+      slot_ = parent_(slot);
+    }
+  }
+  return *this;
+}
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr static_bst<Key, Value, N, Traversal, Compare>::static_bst(std::array<value_type, N> items) {
+  std::sort(items.begin(), items.end(), [](const value_type& lhs, const value_type& rhs) {
+    return key_compare{}(lhs.first, rhs.first);
+  });
+  for (size_t i = 1; i < N; ++i) {
+    if (!key_compare{}(items[i - 1].first, items[i].first)) {
+      throw std::invalid_argument("static_bst keys must be unique");
+    }
+  }
+  size_t next = 0;
+  fill_(items, next, 0);
+}
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr void static_bst<Key, Value, N, Traversal, Compare>::fill_(const std::array<value_type, N>& sorted,
+                                                                    size_t& next,
+                                                                    size_t slot) {
+  // an in-order walk over the slots hands out the sorted elements
+  if (slot >= N) {
+    return;
+  }
+  fill_(sorted, next, 2 * slot + 1);
+  nodes_[slot] = sorted[next++];
+  fill_(sorted, next, 2 * slot + 2);
+}
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr size_t static_bst<Key, Value, N, Traversal, Compare>::locate_(const key_type& key) const {
+  size_t slot = 0;
+  while (slot < N) {
+    if (key_compare{}(key, nodes_[slot].first)) {
+      slot = 2 * slot + 1;
+    } else if (key_compare{}(nodes_[slot].first, key)) {
+      slot = 2 * slot + 2;
+    } else {
+      return slot;
+    }
+  }
+  return N;
+}
+
+template<class Key, class Value, std::size_t N, class Traversal, class Compare>
+constexpr static_bst<Key, Value, N, Traversal, Compare>::iterator static_bst<Key,
+                                                                            Value,
+                                                                            N,
+                                                                            Traversal,
+                                                                            Compare>::lower_bound(const key_type& key) const {
+  size_t bound = N;
+  size_t slot = 0;
+  while (slot < N) {
+    if (key_compare{}(nodes_[slot].first, key)) {
+      slot = 2 * slot + 2;
+    } else {
+      bound = slot;
+      slot = 2 * slot + 1;
+    }
+  }
+  return iterator(this, bound);
+}
+
+// make_static_bst<Key, Value>({{k, v}, ...}); the element count is deduced from the list
+template<class Key, class Value, class Traversal = Preorder, class Compare = std::less<Key>, std::size_t N>
+constexpr static_bst<Key, Value, N, Traversal, Compare> make_static_bst(std::pair<Key, Value> (&&items)[N]) {
+  return static_bst<Key, Value, N, Traversal, Compare>(std::to_array(std::move(items)));
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <lib/iterator/bst_iterator.hpp>
+
+// bst keyed by std::string with prefix-compressed keys. A node stores only the bytes that
+// differ from its parent's key: key = parent_key.substr(0, prefix) + suffix. Suffixes of up
+// to 15 bytes stay inline in the node thanks to std::string's small-buffer optimization.
+//
+// Searches never re-compare a prefix already matched higher up: with m = lcp(key, parent_key),
+// a node whose prefix exceeds m orders the same way as its parent without touching any bytes,
+// otherwise comparison resumes at byte prefix, never at byte 0.
+template<class Value, class Traversal = Preorder,
+    class Alloc = std::allocator<std::pair<std::string, Value>>>
+class string_bst {
+ protected:
+  struct Node {
+    std::uint32_t prefix = 0;
+    std::string suffix;
+    Value value;
+
+    Node* left = nullptr;
+    Node* right = nullptr;
+    Node* parent = nullptr;
+
+    Node(std::uint32_t prefix, std::string suffix, const Value& value)
+        : prefix(prefix), suffix(std::move(suffix)), value(value) {}
+  };
+
+  size_t size_ = 0;
+  Node* root_ = nullptr;
+
+  // result of a descent: the node with the key or the parent the key would hang from
+  struct position {
+    Node* node = nullptr;
+    Node* parent = nullptr;
+    bool left = false;
+    size_t matched = 0;  // lcp of the key with parent's key
+  };
+
+  position find_(std::string_view key) const;
+  static std::string key_(const Node* current);
+  void reencode_(Node* current, const std::string& key);
+  void replace_(Node* current, Node* child);
+  void del_(Node* current);
+  Node* copy_(const Node* other, Node* parent);
+
+ public:
+  class iterator;
+
+  using key_type = std::string;
+  using mapped_type = Value;
+  using size_type = std::size_t;
+  using value_type = std::pair<std::string, Value>;
+  using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+  using allocator_traits = typename std::allocator_traits<allocator_type>;
+
+  allocator_type allocator_;
+
+  string_bst() noexcept = default;
+  string_bst(std::initializer_list<value_type> initializer_list) { insert(initializer_list); }
+  string_bst(const string_bst& other)
+      : size_(other.size_), allocator_(allocator_traits::select_on_container_copy_construction(other.allocator_)) {
+    root_ = copy_(other.root_, nullptr);
+  }
+  string_bst& operator=(string_bst other) noexcept {
+    std::swap(size_, other.size_);
+    std::swap(root_, other.root_);
+    std::swap(allocator_, other.allocator_);
+    return *this;
+  }
+  ~string_bst() { del_(root_); }
+
+  void insert(const value_type& value);
+  void insert(std::initializer_list<value_type> initializer_list);
+
+  void extract(std::string_view key);
+
+  bool contains(std::string_view key) const { return find_(key).node != nullptr; }
+  size_t count(std::string_view key) const { return contains(key); }
+
+  size_t size() const noexcept { return size_; }
+  void clear();
+
+  iterator begin() const { return iterator(iterator::first_(root_)); }
+  iterator end() const { return iterator(); }
+};
+
+template<class Value, class Traversal, class Alloc>
+class string_bst<Value, Traversal, Alloc>::iterator {
+ private:
+  const Node* current_ = nullptr;
+
+  static const Node* first_(const Node* root);
+  friend class string_bst;
+
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using traversal = Traversal;
+
+  iterator() = default;
+  explicit iterator(const Node* current) : current_(current) {}
+
+  // rebuilt from the path to the root, O(depth)
+  std::string key() const { return key_(current_); }
+  const Value& value() const noexcept { return current_->value; }
+  value_type operator*() const { return value_type(key(), value()); }
+
+  iterator& operator++() noexcept;
+  iterator operator++(int) noexcept {
+    iterator tmp = *this;
+    operator++();
+    return tmp;
+  }
+
+  bool operator==(const iterator& other) const noexcept { return current_ == other.current_; }
+  bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+};
+
+template<class Value, class Traversal, class Alloc>
+const typename string_bst<Value, Traversal, Alloc>::Node* string_bst<Value,
+                                                                     Traversal,
+                                                                     Alloc>::iterator::first_(const Node* root) {
+  if (!root || std::is_same_v<Traversal, Preorder>) {
+    return root;
+  }
+  while (root->left || (std::is_same_v<Traversal, Postorder> && root->right)) {
+    root = root->left ? root->left : root->right;
+  }
+  return root;
+}
+
+template<class Value, class Traversal, class Alloc>
+string_bst<Value, Traversal, Alloc>::iterator& string_bst<Value, Traversal, Alloc>::iterator::operator++() noexcept {
+  const Node* current = current_;
+  if constexpr (std::is_same_v<Traversal, Preorder>) {
+    if (current->left || current->right) {
+      current_ = current->left ? current->left : current->right;
+      return *this;
+    }
+    while (current->parent && (current == current->parent->right || !current->parent->right)) {
+      current = current->parent;
+    }
+    current_ = current->parent ? current->parent->right : nullptr;
+  } else if constexpr (std::is_same_v<Traversal, Inorder>) {
+    if (current->right) {
+      current_ = first_(current->right);
+      return *this;
+    }
+    while (current->parent && current == current->parent->right) {
+      current = current->parent;
+    }
+    current_ = current->parent;
+  } else if constexpr (std::is_same_v<Traversal, Postorder>) {
+    const Node* parent = current->parent;
+    current_ = (parent && current == parent->left && parent->right) ? first_(parent->right) : parent;
+  }
+  return *this;
+}
+
+template<class Value, class Traversal, class Alloc>
+string_bst<Value, Traversal, Alloc>::position string_bst<Value, Traversal, Alloc>::find_(std::string_view key) const {
+  position result;
+  bool less = false;
+  Node* current = root_;
+  while (current) {
+    if (current->prefix <= result.matched) {
+      // key and current agree on the first prefix bytes, compare the rest
+      size_t i = current->prefix;
+      size_t j = 0;
+      while (i < key.size() && j < current->suffix.size() && key[i] == current->suffix[j]) {
+        ++i;
+        ++j;
+      }
+      if (i == key.size() && j == current->suffix.size()) {
+        result.node = current;
+        return result;
+      }
+      less = j < current->suffix.size()
+          && (i == key.size() || static_cast<unsigned char>(key[i]) < static_cast<unsigned char>(current->suffix[j]));
+      result.matched = i;
+    }
+    // otherwise current shares more with its parent than key does, so it orders like the parent
+    result.parent = current;
+    result.left = less;
+    current = less ? current->left : current->right;
+  }
+  return result;
+}
+
+template<class Value, class Traversal, class Alloc>
+std::string string_bst<Value, Traversal, Alloc>::key_(const Node* current) {
+  if (!current->parent) {
+    return current->suffix;
+  }
+  std::string key = key_(current->parent);
+  key.resize(current->prefix);
+  key += current->suffix;
+  return key;
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::reencode_(Node* current, const std::string& key) {
+  if (!current) {
+    return;
+  }
+  size_t prefix = 0;
+  if (current->parent) {
+    std::string parent_key = key_(current->parent);
+    while (prefix < key.size() && prefix < parent_key.size() && key[prefix] == parent_key[prefix]) {
+      ++prefix;
+    }
+  }
+  current->prefix = static_cast<std::uint32_t>(prefix);
+  current->suffix = key.substr(prefix);
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::replace_(Node* current, Node* child) {
+  if (!current->parent) {
+    root_ = child;
+  } else if (current->parent->left == current) {
+    current->parent->left = child;
+  } else {
+    current->parent->right = child;
+  }
+  if (child) {
+    child->parent = current->parent;
+  }
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::insert(const value_type& value) {
+  if (value.first.size() > UINT32_MAX) {
+    throw std::length_error("string_bst keys are limited to 2^32 - 1 bytes");
+  }
+  position found = find_(value.first);
+  if (found.node) {
+    if (value.second < found.node->value) {
+      found.node->value = value.second;
+    }
+    return;
+  }
+  Node* new_node = allocator_traits::allocate(allocator_, 1);
+  allocator_traits::construct(allocator_, new_node, static_cast<std::uint32_t>(found.matched),
+                              value.first.substr(found.matched), value.second);
+  new_node->parent = found.parent;
+  if (!found.parent) {
+    root_ = new_node;
+  } else if (found.left) {
+    found.parent->left = new_node;
+  } else {
+    found.parent->right = new_node;
+  }
+  ++size_;
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::insert(std::initializer_list<value_type> initializer_list) {
+  for (const auto& item : initializer_list) {
+    insert(item);
+  }
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::extract(std::string_view key) {
+  Node* current = find_(key).node;
+  if (!current) {
+    return;
+  }
+  // children hung below a different parent have to be re-encoded against its key,
+  // so their full keys are taken before any link changes
+  if (!current->left || !current->right) {
+    Node* child = current->left ? current->left : current->right;
+    std::string child_key = child ? key_(child) : std::string();
+    replace_(current, child);
+    reencode_(child, child_key);
+  } else {
+    Node* successor = current->right;
+    while (successor->left) {
+      successor = successor->left;
+    }
+    std::string successor_key = key_(successor);
+    std::string left_key = key_(current->left);
+    std::string right_key = successor != current->right ? key_(current->right) : std::string();
+    Node* orphan = successor->right;
+    std::string orphan_key = orphan ? key_(orphan) : std::string();
+
+    if (successor != current->right) {
+      replace_(successor, orphan);
+      successor->right = current->right;
+      successor->right->parent = successor;
+    }
+    replace_(current, successor);
+    successor->left = current->left;
+    successor->left->parent = successor;
+
+    reencode_(successor, successor_key);
+    reencode_(successor->left, left_key);
+    if (successor->right != orphan) {
+      reencode_(successor->right, right_key);
+    }
+    reencode_(orphan, orphan_key);
+  }
+  allocator_traits::destroy(allocator_, current);
+  allocator_traits::deallocate(allocator_, current, 1);
+  --size_;
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::clear() {
+  del_(root_);
+  root_ = nullptr;
+  size_ = 0;
+}
+
+template<class Value, class Traversal, class Alloc>
+void string_bst<Value, Traversal, Alloc>::del_(Node* current) {
+  if (!current) return;
+  del_(current->left);
+  del_(current->right);
+  allocator_traits::destroy(allocator_, current);
+  allocator_traits::deallocate(allocator_, current, 1);
+}
+
+template<class Value, class Traversal, class Alloc>
+string_bst<Value, Traversal, Alloc>::Node* string_bst<Value, Traversal, Alloc>::copy_(const Node* other, Node* parent) {
+  if (!other) {
+    return nullptr;
+  }
+  Node* new_node = allocator_traits::allocate(allocator_, 1);
+  allocator_traits::construct(allocator_, new_node, other->prefix, other->suffix, other->value);
+  new_node->parent = parent;
+  new_node->left = copy_(other->left, new_node);
+  new_node->right = copy_(other->right, new_node);
+  return new_node;
+}
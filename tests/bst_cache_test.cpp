@@ -0,0 +1,94 @@
+#include <lib/bst_cache.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+TEST(BST_CACHE, LRU_EVICTS_LEAST_RECENTLY_USED) {
+  bst_cache<int, int> a(3);
+  a.insert({{1, 10}, {2, 20}, {3, 30}});
+  ASSERT_NE(a.find(1), (bst_cache<int, int>::iterator()));
+  a.insert({4, 40});
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_FALSE(a.contains(2));
+  ASSERT_TRUE(a.contains(1));
+  a.insert({3, 33});
+  a.insert({5, 50});
+  ASSERT_FALSE(a.contains(1));
+  ASSERT_EQ((*a.find(3)).value.second.value, 33);
+  ASSERT_EQ(a.stats().evictions, 2);
+}
+
+TEST(BST_CACHE, LFU_EVICTS_LEAST_FREQUENTLY_USED) {
+  bst_cache<int, int, lfu> a(3);
+  a.insert({{1, 10}, {2, 20}, {3, 30}});
+  a.find(1);
+  a.find(1);
+  a.find(3);
+  a.insert({4, 40});
+  ASSERT_FALSE(a.contains(2));
+  // 4 has one use and is the oldest of the single-use elements
+  a.insert({5, 50});
+  ASSERT_FALSE(a.contains(4));
+  ASSERT_TRUE(a.contains(1));
+  ASSERT_TRUE(a.contains(3));
+}
+
+TEST(BST_CACHE, STATS_AND_ORDERED_ITERATION) {
+  bst_cache<int, int, lru, Inorder> a(4);
+  for (int key : {5, 3, 8, 1, 9, 7}) {
+    a.insert({key, key});
+  }
+  ASSERT_EQ(a.find(3), (bst_cache<int, int, lru, Inorder>::iterator()));
+  a.find(9);
+  a.find(9);
+  ASSERT_EQ(a.stats().hits, 2);
+  ASSERT_EQ(a.stats().misses, 1);
+  ASSERT_EQ(a.stats().evictions, 2);
+  int expected[] = {1, 7, 8, 9};
+  // begin() is the root, the first increment moves to the smallest key
+  auto it = ++a.begin();
+  for (int i = 0; i < 4; i++, ++it) {
+    ASSERT_EQ((*it).value.first, expected[i]);
+  }
+}
+
+TEST(BST_CACHE, ERASE_AND_SHRINK) {
+  bst_cache<int, int, lfu> a(4);
+  a.insert({{1, 1}, {2, 2}, {3, 3}, {4, 4}});
+  a.find(4);
+  ASSERT_EQ(a.erase(1), 1);
+  ASSERT_EQ(a.erase(1), 0);
+  a.capacity(1);
+  ASSERT_EQ(a.size(), 1);
+  ASSERT_TRUE(a.contains(4));
+  a.clear();
+  a.insert({6, 6});
+  ASSERT_TRUE(a.contains(6));
+}
+
+TEST(BST_CACHE, LRU_MATCHES_REFERENCE_MODEL) {
+  bst_cache<int, int> a(16);
+  std::map<int, int> last_use;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> keys(0, 40);
+  for (int step = 0; step < 5000; step++) {
+    int key = keys(gen);
+    if (step % 3) {
+      bool hit = a.find(key) != bst_cache<int, int>::iterator();
+      ASSERT_EQ(hit, last_use.count(key) == 1);
+      if (hit) last_use[key] = step;
+    } else {
+      if (!last_use.count(key) && last_use.size() == 16) {
+        auto oldest = std::min_element(last_use.begin(), last_use.end(), [](auto& lhs, auto& rhs) {
+          return lhs.second < rhs.second;
+        });
+        last_use.erase(oldest);
+      }
+      a.insert({key, step});
+      last_use[key] = step;
+    }
+    ASSERT_EQ(a.size(), last_use.size());
+  }
+}
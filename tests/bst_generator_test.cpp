@@ -0,0 +1,170 @@
+#include <lib/bst.hpp>
+#include <lib/iterator/bst_generator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+//       100
+//     20    200
+//   10  30 150 300
+bst<int, int> sample() {
+  return {{100, 1}, {20, 2}, {10, 3}, {30, 4}, {200, 5}, {150, 6}, {300, 7}};
+}
+
+template<class Generator>
+std::vector<int> keys(Generator&& generator) {
+  std::vector<int> result;
+  for (auto& value : generator) {
+    result.push_back(value.first);
+  }
+  return result;
+}
+
+// single-threaded run queue standing in for an event loop
+struct run_queue {
+  std::deque<std::coroutine_handle<>> ready;
+
+  auto yield() {
+    struct awaiter {
+      run_queue& queue;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) { queue.ready.push_back(handle); }
+      void await_resume() const noexcept {}
+    };
+    return awaiter{*this};
+  }
+
+  void run() {
+    while (!ready.empty()) {
+      auto handle = ready.front();
+      ready.pop_front();
+      handle.resume();
+    }
+  }
+};
+
+struct detached {
+  struct promise_type {
+    detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const { std::terminate(); }
+  };
+};
+
+detached sliced_scan(run_queue& queue, bst<int, int>& tree, size_t slice, std::vector<int>& log) {
+  auto scan = tree.scan_async(Inorder{});
+  size_t seen = 0;
+  while (auto* value = co_await scan.next()) {
+    log.push_back(value->first);
+    if (++seen % slice == 0) co_await queue.yield();
+  }
+}
+
+detached ticker(run_queue& queue, int ticks, std::vector<int>& log) {
+  for (int i = 0; i < ticks; i++) {
+    co_await queue.yield();
+    log.push_back(-1);
+  }
+}
+
+}  // namespace
+
+TEST(BST_GENERATOR, ORDERS) {
+  auto tree = sample();
+  ASSERT_EQ(keys(tree.scan(Preorder{})), (std::vector<int>{100, 20, 10, 30, 200, 150, 300}));
+  ASSERT_EQ(keys(tree.scan(Inorder{})), (std::vector<int>{10, 20, 30, 100, 150, 200, 300}));
+  ASSERT_EQ(keys(tree.scan(Postorder{})), (std::vector<int>{10, 30, 20, 150, 300, 200, 100}));
+  ASSERT_TRUE(keys(bst<int, int>{}.scan()).empty());
+}
+
+TEST(BST_GENERATOR, MATCHES_ITERATOR_ON_DEGENERATE_TREES) {
+  bst<int, int> left;
+  bst<int, int> right;
+  for (int i = 0; i < 100; i++) {
+    left.insert({100 - i, i});
+    right.insert({i, i});
+  }
+  std::vector<int> ascending;
+  for (int i = 1; i <= 100; i++) ascending.push_back(i);
+  ASSERT_EQ(keys(left.scan(Inorder{})), ascending);
+  ASSERT_EQ(keys(left.scan(Postorder{})), ascending);
+  ascending.insert(ascending.begin(), 0);
+  ascending.pop_back();
+  ASSERT_EQ(keys(right.scan(Preorder{})), ascending);
+}
+
+TEST(BST_GENERATOR, STEP_RESUMES_WHERE_IT_STOPPED) {
+  auto tree = sample();
+  auto scan = tree.scan(Inorder{});
+  std::vector<int> seen;
+  auto collect = [&](auto& value) { seen.push_back(value.first); };
+  ASSERT_TRUE(scan.step(3, collect));
+  ASSERT_EQ(seen, (std::vector<int>{10, 20, 30}));
+  ASSERT_TRUE(scan.step(3, collect));
+  ASSERT_FALSE(scan.step(3, collect));
+  ASSERT_TRUE(scan.done());
+  ASSERT_EQ(seen, (std::vector<int>{10, 20, 30, 100, 150, 200, 300}));
+}
+
+TEST(BST_GENERATOR, BREAK_KEEPS_ELEMENT_PENDING) {
+  auto tree = sample();
+  auto scan = tree.scan(Preorder{});
+  for (auto& value : scan) {
+    if (value.first == 10) break;
+  }
+  ASSERT_EQ((*scan.begin()).first, 10);
+  ASSERT_EQ(keys(scan), (std::vector<int>{10, 30, 200, 150, 300}));
+}
+
+TEST(BST_GENERATOR, STEP_FOR_BUDGET) {
+  bst<int, int> tree;
+  for (int i = 0; i < 1000; i++) {
+    tree.insert({(i * 7919) % 1000, i});
+  }
+  auto scan = tree.scan(Inorder{});
+  int expected = 0;
+  size_t slices = 0;
+  bool more = true;
+  while (more) {
+    more = scan.step_for(std::chrono::microseconds(0), [&](auto& value) { ASSERT_EQ(value.first, expected++); });
+    ++slices;
+  }
+  ASSERT_EQ(expected, 1000);
+  ASSERT_EQ(slices, 1000);
+}
+
+TEST(BST_GENERATOR, SCAN_UPDATES_VALUES) {
+  auto tree = sample();
+  tree.scan().step(100, [](auto& value) { value.second *= 10; });
+  std::vector<int> values;
+  for (auto& value : tree.scan(Inorder{})) values.push_back(value.second);
+  ASSERT_EQ(values, (std::vector<int>{30, 20, 40, 10, 60, 50, 70}));
+}
+
+TEST(BST_GENERATOR, CONST_TREE_YIELDS_CONST_ELEMENTS) {
+  const auto tree = sample();
+  auto scan = tree.scan(Inorder{});
+  static_assert(std::is_same_v<decltype(*scan.begin()), const std::pair<int, int>&>);
+  auto async_scan = tree.scan_async(Inorder{});
+  static_assert(std::is_same_v<decltype(async_scan.next().await_resume()), const std::pair<int, int>*>);
+  ASSERT_EQ(keys(scan), (std::vector<int>{10, 20, 30, 100, 150, 200, 300}));
+}
+
+TEST(BST_GENERATOR, ASYNC_SCAN_INTERLEAVES_WITH_OTHER_WORK) {
+  auto tree = sample();
+  run_queue queue;
+  std::vector<int> log;
+  sliced_scan(queue, tree, 3, log);
+  ticker(queue, 2, log);
+  queue.run();
+  ASSERT_EQ(log, (std::vector<int>{10, 20, 30, 100, 150, 200, -1, 300, -1}));
+}
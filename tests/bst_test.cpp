@@ -334,3 +334,577 @@ TEST(BST_OPERATIONS, SQUARE_BRACKETS) {
   auto c = a.begin();
   ASSERT_EQ(b, c);
 }
+
+TEST(BST_OPERATIONS, EXTRACT_ONLY_ELEMENT_EMPTIES_END) {
+  bst<int, int> a{{1, 1}};
+  a.extract(1);
+  ASSERT_EQ(a.size(), 0);
+  bst<int, int>::iterator empty;
+  ASSERT_TRUE(a.end() == empty);
+}
+
+namespace {
+
+// get_max_ is only reached through the public interface once last_ needs recomputing
+struct max_probe : bst<int, int> {
+  using bst::bst;
+  int max_key() { return get_max_(root_)->value.first; }
+};
+
+}  // namespace
+
+TEST(BST_OPERATIONS, GET_MAX_FOLLOWS_RIGHT_SPINE) {
+  //   5
+  //     8
+  //   7   9
+  max_probe a{{5, 1}, {8, 2}, {7, 3}, {9, 4}};
+  ASSERT_EQ(a.max_key(), 9);
+}
+
+TEST(BST_OPERATIONS, EXTRACT_ROOT_DETACHES_NEW_ROOT) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, splay_tree> a{
+      {10, 1}, {20, 2}, {30, 3}};
+  a.extract(10);
+  // splaying climbs parent links up to the root
+  ASSERT_TRUE(a.contains(30));
+  ASSERT_EQ((*a.begin()).value.first, 30);
+  ASSERT_EQ(a.size(), 2);
+}
+
+TEST(BST_AGGREGATE, SUM_OVER_RANGE) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  ASSERT_EQ(a.aggregate(), 21);
+  ASSERT_EQ(a.aggregate(20, 150), 8);
+  ASSERT_EQ(a.aggregate(11, 299), 12);
+  ASSERT_EQ(a.aggregate(301, 400), 0);
+}
+
+TEST(BST_AGGREGATE, MIN_MAX_OVER_RANGE) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, min_of<int>> a{
+      {100, 7}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, max_of<int>> b{
+      {100, 7}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  ASSERT_EQ(a.aggregate(100, 300), 4);
+  ASSERT_EQ(a.aggregate(10, 20), 2);
+  ASSERT_EQ(b.aggregate(150, 300), 6);
+  ASSERT_EQ(b.aggregate(0, 1000), 7);
+}
+
+TEST(BST_AGGREGATE, COUNT_AFTER_EXTRACT) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, count_of<>> a{
+      {100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  ASSERT_EQ(a.aggregate(10, 200), 5);
+  a.extract(100);
+  a.extract(10);
+  ASSERT_EQ(a.aggregate(10, 200), 3);
+  ASSERT_EQ(a.aggregate(), a.size());
+}
+
+TEST(BST_BALANCE, SPLAY_MOVES_FOUND_KEY_TO_ROOT) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, splay_tree> a{
+      {100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  ASSERT_TRUE(a.contains(150));
+  ASSERT_EQ((*a.begin()).value.first, 150);
+  ASSERT_TRUE(a.contains(10));
+  ASSERT_EQ((*a.begin()).value.first, 10);
+  for (int key : {100, 20, 10, 200, 150, 300}) {
+    ASSERT_TRUE(a.contains(key));
+  }
+  ASSERT_EQ(a.size(), 6);
+}
+
+TEST(BST_BALANCE, SPLAY_MISS_KEEPS_SHAPE) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, splay_tree> a{
+      {100, 1}, {20, 1}, {10, 1}};
+  ASSERT_FALSE(a.contains(15));
+  ASSERT_EQ((*a.begin()).value.first, 100);
+}
+
+TEST(BST_BALANCE, SEMI_SPLAY_HALVES_DEPTH) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, semi_splay_tree> a{
+      {5, 1}, {4, 1}, {3, 1}, {2, 1}, {1, 1}};
+  ASSERT_TRUE(a.contains(1));
+  // 5-4-3-2-1 chain: both zig-zig steps rotate the parent, leaving 4 on top with 2 below it
+  auto it = a.begin();
+  ASSERT_EQ((*it).value.first, 4);
+  ASSERT_EQ((*++it).value.first, 2);
+}
+
+TEST(BST_BALANCE, SPLAY_KEEPS_AGGREGATES) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>, splay_tree> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  a.contains(10);
+  a.contains(300);
+  a.contains(150);
+  ASSERT_EQ(a.aggregate(), 21);
+  ASSERT_EQ(a.aggregate(20, 150), 8);
+}
+
+TEST(BST_MULTI, INSERT_KEEPS_DUPLICATES) {
+  bst_multi<int, int> a{{2, 1}, {1, 1}, {2, 2}, {3, 1}, {2, 3}};
+  ASSERT_EQ(a.size(), 5);
+  ASSERT_EQ(a.count(2), 3);
+  ASSERT_EQ(a.count(1), 1);
+  ASSERT_EQ(a.count(4), 0);
+}
+
+TEST(BST_MULTI, EQUAL_RANGE_IN_INSERTION_ORDER) {
+  bst_multi<int, int, Inorder> a{{2, 1}, {1, 1}, {2, 2}, {3, 1}, {2, 3}};
+  auto [first, last] = a.equal_range(2);
+  ASSERT_EQ((*first).value.second, 1);
+  ASSERT_EQ((*last).value.second, 3);
+  auto [none_first, none_last] = a.equal_range(5);
+  ASSERT_EQ(none_first, decltype(a)::iterator());
+  ASSERT_EQ(none_last, decltype(a)::iterator());
+}
+
+TEST(BST_MULTI, ERASE_ALL_EQUAL) {
+  bst_multi<int, int> a{{2, 1}, {1, 1}, {2, 2}, {3, 1}, {2, 3}, {0, 1}};
+  ASSERT_EQ(a.erase(2), 3);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(a.count(2), 0);
+  ASSERT_EQ(a.count(3), 1);
+  ASSERT_EQ(a.erase(2), 0);
+  ASSERT_EQ(a.aggregate(), 3);
+}
+
+TEST(BST_MULTI, EQUAL_RANGE_AFTER_ERASE_IF) {
+  bst_multi<int, int, Inorder> a{{0, 0}, {1, 1}, {1, 2}, {1, 3}, {5, 5}};
+  ASSERT_EQ(a.erase_if([](const std::pair<int, int>& value) { return value.first == 5; }), 1);
+  auto [first, last] = a.equal_range(1);
+  ASSERT_EQ((*first).value.second, 1);
+  ASSERT_EQ((*last).value.second, 3);
+  ASSERT_EQ(a.count(1), 3);
+}
+
+TEST(BST_MULTI, ERASE_IF_WITH_LONG_EQUAL_RUNS) {
+  bst_multi<int, int, Inorder> a;
+  for (int i = 0; i < 4000; i++) {
+    a.insert(a.end(), {i < 2000 ? 7 : i, i});
+  }
+  ASSERT_EQ(a.erase_if([](const std::pair<int, int>& value) { return value.second % 2 == 1; }), 2000);
+  ASSERT_EQ(a.count(7), 1000);
+  auto [first, last] = a.equal_range(7);
+  ASSERT_EQ((*first).value.second, 0);
+  ASSERT_EQ((*last).value.second, 1998);
+  ASSERT_EQ(a.count(3998), 1);
+}
+
+TEST(BST_OPERATIONS, COUNT_UNIQUE) {
+  bst<int, int> a{{2, 1}, {1, 1}, {2, 2}};
+  ASSERT_EQ(a.count(2), 1);
+  ASSERT_EQ(a.count(3), 0);
+  ASSERT_EQ(a.erase(2), 1);
+  ASSERT_EQ(a.size(), 1);
+}
+
+TEST(BST_CONFLICT, KEEP_MIN_BY_DEFAULT) {
+  bst<int, int> a{{1, 5}, {1, 3}, {1, 4}};
+  ASSERT_EQ((*a.begin()).value.second, 3);
+}
+
+TEST(BST_CONFLICT, KEEP_FIRST_AND_OVERWRITE) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, plain_tree, keep_first> a{
+      {1, 5}, {1, 3}, {1, 4}};
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, no_augment, plain_tree, overwrite> b{
+      {1, 5}, {1, 3}, {1, 4}};
+  ASSERT_EQ((*a.begin()).value.second, 5);
+  ASSERT_EQ((*b.begin()).value.second, 4);
+  ASSERT_EQ(b.size(), 1);
+}
+
+TEST(BST_CONFLICT, COMBINE_KEEPS_AGGREGATES) {
+  bst<int, int, Preorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>, plain_tree,
+      combine<std::plus<>>> a{{2, 1}, {1, 1}, {2, 1}, {2, 1}};
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_EQ((*a.begin()).value.second, 3);
+  ASSERT_EQ(a.aggregate(), 4);
+}
+
+TEST(BST_CONFLICT, INSERT_OR_ASSIGN) {
+  bst<int, int> a{{1, 5}, {2, 3}};
+  a.insert_or_assign({1, 7});
+  a.insert_or_assign({3, 9});
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ((*a.begin()).value.second, 7);
+  ASSERT_TRUE(a.contains(3));
+}
+
+TEST(BST_CONFLICT, UPSERT_COUNTER) {
+  bst<std::string, int, Preorder, std::less<std::string>, std::allocator<std::pair<std::string, int>>,
+      sum_of<int>> a;
+  for (const char* word : {"foo", "bar", "foo", "baz", "foo"}) {
+    a.upsert(word, [](int& count) { ++count; });
+  }
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ((*a.begin()).value.second, 3);
+  ASSERT_EQ(a.aggregate(), 5);
+  ASSERT_EQ(a.aggregate("baz", "foo"), 4);
+}
+
+TEST(BST_ERASE, ERASE_ITERATOR) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, count_of<>> a{
+      {100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  auto next = a.erase(a.begin());
+  ASSERT_EQ((*next).value.first, 150);
+  ASSERT_EQ(a.size(), 5);
+  ASSERT_FALSE(a.contains(100));
+  ASSERT_EQ(a.aggregate(), 5);
+  ASSERT_EQ((*a.begin()).value.first, 150);
+}
+
+TEST(BST_ERASE, ERASE_LAST_ELEMENT) {
+  bst<int, int> a{{2, 1}, {1, 1}, {3, 1}};
+  auto next = a.erase(a.end());
+  ASSERT_EQ(next, decltype(a)::iterator());
+  ASSERT_EQ((*a.end()).value.first, 2);
+  ASSERT_EQ(a.size(), 2);
+}
+
+TEST(BST_ERASE, ERASE_RANGE) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}, {15, 7}, {250, 8}};
+  auto next = a.erase(a.equal_range(20).first, a.equal_range(250).first);
+  ASSERT_EQ((*next).value.first, 300);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ(a.aggregate(), 16);
+  ASSERT_TRUE(a.contains(10));
+  ASSERT_TRUE(a.contains(15));
+  ASSERT_FALSE(a.contains(150));
+  ASSERT_EQ((*a.end()).value.first, 300);
+}
+
+TEST(BST_ERASE, ERASE_IN_PREORDER) {
+  //       100
+  //     20    200
+  //   10    150  300
+  bst<int, int> a{{100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  auto next = a.erase(a.equal_range(200).first);
+  ASSERT_EQ((*next).value.first, 150);
+  ASSERT_EQ(a.size(), 5);
+
+  auto first = a.begin();
+  auto second = a.equal_range(20).first;
+  next = a.erase(first, second);
+  ASSERT_EQ((*next).value.first, 10);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_FALSE(a.contains(100));
+  ASSERT_FALSE(a.contains(20));
+  ASSERT_TRUE(a.contains(150));
+}
+
+TEST(BST_ERASE, ERASE_IN_POSTORDER) {
+  // postorder: 10 20 150 300 200 100
+  bst<int, int, Postorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  auto next = a.erase(a.equal_range(10).first);
+  ASSERT_EQ((*next).value.first, 20);
+
+  next = a.erase(a.equal_range(20).first, a.equal_range(300).first);
+  ASSERT_EQ((*next).value.first, 200);
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_EQ(a.aggregate(), 5);
+
+  next = a.erase(a.equal_range(100).first);
+  ASSERT_EQ(next, decltype(a)::iterator());
+  ASSERT_EQ(a.size(), 1);
+}
+
+TEST(BST_ERASE, ERASE_IF) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a;
+  for (int i = 0; i < 100; i++) {
+    a.insert({i, i});
+  }
+  ASSERT_EQ(a.erase_if([](const std::pair<int, int>& value) { return value.first % 2 == 0; }), 50);
+  ASSERT_EQ(a.size(), 50);
+  ASSERT_EQ(a.aggregate(), 2500);
+  ASSERT_FALSE(a.contains(42));
+  ASSERT_TRUE(a.contains(43));
+  ASSERT_EQ((*a.end()).value.first, 99);
+}
+
+TEST(BST_CLEAR, CLEAR) {
+  bst<int, int> a{{100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  a.clear();
+  ASSERT_EQ(a.size(), 0);
+  ASSERT_FALSE(a.contains(100));
+  a.insert({1, 1});
+  ASSERT_EQ(a.size(), 1);
+  ASSERT_EQ((*a.begin()).value.first, 1);
+}
+
+TEST(BST_CLEAR, CLEAR_DEGENERATE_TREE) {
+  bst<int, int> a;
+  for (int i = 0; i < 10000; i++) {
+    a.insert({i, i});
+  }
+  a.clear();
+  ASSERT_EQ(a.size(), 0);
+}
+
+TEST(BST_CLEAR, CLEAR_ASYNC) {
+  bst<int, int> a{{100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  auto freed = a.clear_async();
+  ASSERT_EQ(a.size(), 0);
+  a.insert({1, 1});
+  ASSERT_TRUE(a.contains(1));
+  ASSERT_EQ(freed.get(), 6);
+}
+
+struct counting_less {
+  static inline size_t comparisons = 0;
+  bool operator()(int lhs, int rhs) const {
+    ++comparisons;
+    return lhs < rhs;
+  }
+};
+
+TEST(BST_HINT, SORTED_STREAM_IS_CONSTANT_PER_INSERT) {
+  bst<int, int, Inorder, counting_less> a;
+  counting_less::comparisons = 0;
+  for (int i = 0; i < 10000; i++) {
+    a.insert(a.end(), {i, i});
+  }
+  ASSERT_EQ(a.size(), 10000);
+  ASSERT_LT(counting_less::comparisons, 5 * 10000);
+  int expected = 0;
+  for (auto it = a.begin(); expected < 10000; ++it, ++expected) {
+    ASSERT_EQ((*it).value.first, expected);
+  }
+}
+
+TEST(BST_HINT, MATCHES_PLAIN_INSERT) {
+  bst<int, int, Inorder> hinted;
+  bst<int, int, Inorder> plain;
+  auto hint = hinted.end();
+  for (int i = 0; i < 500; i++) {
+    int key = (i * 7919) % 1000;
+    hint = hinted.insert(i % 3 ? hint : decltype(hint)(), {key, i});
+    plain.insert({key, i});
+    ASSERT_EQ((*hint).value.first, key);
+  }
+  ASSERT_EQ(hinted.size(), plain.size());
+  for (int key = 0; key < 1000; key++) {
+    ASSERT_EQ(hinted.contains(key), plain.contains(key));
+  }
+}
+
+TEST(BST_HINT, EXISTING_KEY_RESOLVES_CONFLICT) {
+  bst<int, int> a{{100, 5}, {20, 1}, {200, 1}};
+  auto it = a.emplace_hint(a.end(), 20, 0);
+  ASSERT_EQ((*it).value.first, 20);
+  ASSERT_EQ((*it).value.second, 0);
+  ASSERT_EQ(a.size(), 3);
+}
+
+TEST(BST_HINT, KEEPS_AGGREGATES_AND_MULTI_ORDER) {
+  bst_multi<int, int, Inorder> a{{10, 1}, {20, 1}, {30, 1}};
+  a.extract(30);
+  auto hint = a.begin();
+  a.insert(hint, {20, 2});
+  a.insert(a.end(), {40, 1});
+  a.insert(a.end(), {20, 3});
+  ASSERT_EQ(a.count(20), 3);
+  ASSERT_EQ(a.aggregate(), 5);
+  auto [first, last] = a.equal_range(20);
+  ASSERT_EQ((*first).value.second, 1);
+  ASSERT_EQ((*last).value.second, 3);
+}
+
+TEST(BST_HINT, COPY_OUTLIVES_SOURCE) {
+  bst<int, int, Inorder> a;
+  {
+    bst<int, int, Inorder> source{{10, 1}, {20, 2}, {5, 3}, {15, 4}};
+    bst<int, int, Inorder> copied(source);
+    a = source;
+    ASSERT_EQ((*copied.end()).value.first, 15);
+  }
+  // an empty hint starts from last_, which must belong to a
+  a.insert(bst<int, int, Inorder>::iterator(), {12, 5});
+  a.insert(a.end(), {30, 6});
+  ASSERT_EQ(a.size(), 6);
+  ASSERT_TRUE(a.contains(12));
+  ASSERT_EQ((*a.end()).value.first, 30);
+}
+
+TEST(BST_COMPACT, KEEPS_ORDER_AND_LINKS) {
+  bst<int, int, Inorder> a;
+  for (int i = 0; i < 1000; i++) {
+    a.insert({(i * 7919) % 1000, i});
+  }
+  auto report = a.compact(Preorder{});
+  ASSERT_EQ(report.bytes, 1000 * sizeof(bst<int, int, Inorder>::allocator_type::value_type));
+  ASSERT_GT(report.after.same_line, 0.4);
+  ASSERT_GE(report.after.same_page, report.before.same_page);
+  ASSERT_EQ(a.size(), 1000);
+  int expected = 0;
+  for (auto it = a.begin(); expected < 1000; ++it, ++expected) {
+    ASSERT_EQ((*it).value.first, expected);
+  }
+}
+
+TEST(BST_COMPACT, MIXES_WITH_LATER_CHURN) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  a.compact(VanEmdeBoas{});
+  a.insert({50, 7});
+  a.extract(20);
+  a.extract(300);
+  ASSERT_EQ(a.aggregate(), 20);
+  a.compact();
+  ASSERT_EQ(a.aggregate(10, 150), 16);
+  ASSERT_TRUE(a.contains(50));
+  ASSERT_FALSE(a.contains(20));
+  a.clear();
+  a.insert({1, 1});
+  ASSERT_EQ(a.size(), 1);
+}
+
+TEST(BST_COMPACT, VAN_EMDE_BOAS_DEGENERATE_TREE) {
+  bst<int, int, Postorder> a;
+  for (int i = 0; i < 10000; i++) {
+    a.insert({i, i});
+  }
+  a.compact(VanEmdeBoas{});
+  ASSERT_EQ(a.locality().same_line, 1.0);
+  for (int i = 0; i < 10000; i += 997) {
+    ASSERT_TRUE(a.contains(i));
+  }
+  // the whole tree in postorder: from the deepest node up to the root
+  a.erase(a.equal_range(9999).first, a.begin());
+  ASSERT_EQ(a.size(), 0);
+}
+
+TEST(BST_MEMORY, NODE_AND_OVERHEAD_BYTES) {
+  bst<int, int> a{{100, 1}, {20, 1}, {10, 1}};
+  const size_t node_size = sizeof(bst<int, int>::allocator_type::value_type);
+  auto usage = a.memory_usage();
+  ASSERT_EQ(usage.node_bytes, 3 * node_size);
+  ASSERT_EQ(usage.heap_bytes, 0);
+  ASSERT_GT(usage.overhead_bytes, 0);
+  size_t scattered = usage.overhead_bytes;
+  a.compact();
+  ASSERT_LT(a.memory_usage().overhead_bytes, scattered);
+  a.extract(20);
+  ASSERT_EQ(a.memory_usage().node_bytes, 2 * node_size);
+}
+
+TEST(BST_MEMORY, HEAP_SIZE_HOOK) {
+  bst<int, std::string> a{{1, "short"}, {2, std::string(100, 'x')}};
+  auto usage = a.memory_usage([](const std::pair<int, std::string>& value) {
+    return value.second.capacity() > 15 ? value.second.capacity() + 1 : 0;
+  });
+  ASSERT_GE(usage.heap_bytes, 101);
+  ASSERT_EQ(usage.total(), usage.node_bytes + usage.heap_bytes + usage.overhead_bytes);
+}
+
+TEST(BST_NODE, EXTRACT_AND_REINSERT_WITHOUT_ALLOCATION) {
+  bst<int, int> a{{100, 1}, {20, 2}, {10, 3}, {200, 4}};
+  bst<int, int> b{{5, 5}};
+  auto handle = a.extract(20);
+  ASSERT_FALSE(handle.empty());
+  ASSERT_EQ(handle.key(), 20);
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_FALSE(a.contains(20));
+  auto* node = &handle.mapped();
+  auto it = b.insert(std::move(handle));
+  ASSERT_TRUE(handle.empty());
+  ASSERT_EQ(&(*it).value.second, node);
+  ASSERT_EQ(b.size(), 2);
+  ASSERT_TRUE(b.contains(20));
+  ASSERT_TRUE(a.extract(42).empty());
+}
+
+TEST(BST_NODE, CONFLICT_LEAVES_NODE_IN_HANDLE) {
+  bst<int, int> a{{1, 1}, {2, 2}};
+  bst<int, int> b{{2, 9}};
+  auto handle = b.extract(2);
+  a.insert(std::move(handle));
+  ASSERT_FALSE(handle.empty());
+  ASSERT_EQ(handle.mapped(), 9);
+  ASSERT_EQ(a.size(), 2);
+}
+
+TEST(BST_NODE, EXTRACT_FROM_COMPACTED_TREE) {
+  bst<int, int, Inorder, std::less<int>, std::allocator<std::pair<int, int>>, sum_of<int>> a{
+      {100, 1}, {20, 2}, {10, 3}, {200, 4}, {150, 5}, {300, 6}};
+  a.compact();
+  auto handle = a.extract(150);
+  ASSERT_EQ(handle.mapped(), 5);
+  ASSERT_EQ(a.aggregate(), 16);
+}
+
+TEST(BST_NODE, SPLIT_AND_JOIN) {
+  bst_multi<int, int, Inorder> a;
+  for (int i = 0; i < 100; i++) {
+    a.insert({i, i});
+  }
+  auto right = a.split(60);
+  ASSERT_EQ(a.size(), 60);
+  ASSERT_EQ(right.size(), 40);
+  ASSERT_EQ(a.aggregate(), 60);
+  ASSERT_FALSE(a.count(60));
+  ASSERT_EQ(right.count(60), 1);
+  ASSERT_EQ((*right.end()).value.first, 99);
+  ASSERT_EQ((*a.end()).value.first, 59);
+
+  auto whole = decltype(a)::join(std::move(a), std::move(right));
+  ASSERT_EQ(whole.size(), 100);
+  ASSERT_EQ(whole.aggregate(), 100);
+  ASSERT_EQ(whole.count(30) + whole.count(80), 2);
+  ASSERT_EQ(right.size(), 0);
+}
+
+TEST(BST_NODE, SIZES_AFTER_SPLIT_WITHOUT_COUNTS) {
+  bst<int, int, Inorder> a;
+  for (int i = 0; i < 100; i++) {
+    a.insert({(i * 37) % 100, i});
+  }
+  auto right = a.split(30);
+  // changes made before the sizes are recounted still count
+  right.insert({1000, 1});
+  right.erase(50);
+  a.erase(10);
+  ASSERT_EQ(right.erase(51), 1);
+  ASSERT_EQ(right.size(), 69);
+  ASSERT_EQ(a.size(), 29);
+
+  auto whole = decltype(a)::join(std::move(a), std::move(right));
+  whole.insert({2000, 1});
+  ASSERT_EQ(whole.size(), 99);
+  ASSERT_EQ(a.size(), 0);
+  ASSERT_EQ(right.size(), 0);
+}
+
+TEST(BST_NODE, SPLIT_COMPACTED_AND_REJECT_OVERLAP) {
+  bst<int, int> a;
+  for (int i = 0; i < 50; i++) {
+    a.insert({(i * 17) % 50, i});
+  }
+  a.compact(VanEmdeBoas{});
+  auto right = a.split(25);
+  ASSERT_EQ(a.size(), 25);
+  ASSERT_EQ(right.size(), 25);
+  for (int key = 0; key < 50; key++) {
+    ASSERT_EQ(a.contains(key), key < 25);
+    ASSERT_EQ(right.contains(key), key >= 25);
+  }
+  using plain = bst<int, int>;
+  ASSERT_THROW(plain::join(std::move(right), std::move(a)), std::invalid_argument);
+}
+
+TEST(BST_NODE, JOIN_REJECTS_EQUAL_BOUNDARY_KEYS) {
+  using plain = bst<int, int>;
+  plain a{{1, 1}, {2, 2}};
+  plain b{{2, 2}, {3, 3}};
+  ASSERT_THROW(plain::join(std::move(a), std::move(b)), std::invalid_argument);
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_EQ(b.size(), 2);
+
+  using multi = bst_multi<int, int>;
+  multi c{{1, 1}, {2, 2}};
+  multi d{{2, 2}, {3, 3}};
+  ASSERT_THROW(multi::join(std::move(c), std::move(d)), std::invalid_argument);
+  ASSERT_EQ(c.count(2) + d.count(2), 2);
+}
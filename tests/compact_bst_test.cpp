@@ -0,0 +1,83 @@
+#include <lib/compact_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <type_traits>
+#include <vector>
+
+template<class Tree>
+std::vector<int> keys(const Tree& tree) {
+  std::vector<int> result;
+  for (auto it = tree.begin(); it != tree.end(); ++it) {
+    result.push_back(it.key());
+  }
+  return result;
+}
+
+TEST(COMPACT_BST_INIT, INITIALIZER_LIST_CONSTRUCTOR) {
+  compact_bst<int, int> a{{1, 2}, {3, 4}};
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_TRUE(a.contains(3));
+}
+
+TEST(COMPACT_BST_OPERATIONS, TRAVERSAL_ORDERS) {
+  std::initializer_list<std::pair<int, int>> values{{100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  //         100
+  //
+  //     20      200
+  //
+  //  10      150   300
+  ASSERT_EQ(keys(compact_bst<int, int, Preorder>(values)), (std::vector<int>{100, 20, 10, 200, 150, 300}));
+  ASSERT_EQ(keys(compact_bst<int, int, Inorder>(values)), (std::vector<int>{10, 20, 100, 150, 200, 300}));
+  ASSERT_EQ(keys(compact_bst<int, int, Postorder>(values)), (std::vector<int>{10, 20, 150, 300, 200, 100}));
+}
+
+TEST(COMPACT_BST_OPERATIONS, TRAVERSAL_IS_REPEATABLE) {
+  compact_bst<int, int, Inorder> a{{2, 1}, {1, 1}, {3, 1}};
+  ASSERT_EQ(keys(a), keys(a));
+}
+
+TEST(COMPACT_BST_OPERATIONS, EXTRACT_VALUE) {
+  compact_bst<int, int, Inorder> a{{100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  a.extract(100);
+  a.extract(10);
+  a.extract(42);
+  ASSERT_EQ(a.size(), 4);
+  ASSERT_FALSE(a.contains(100));
+  ASSERT_EQ(keys(a), (std::vector<int>{20, 150, 200, 300}));
+}
+
+TEST(COMPACT_BST_OPERATIONS, EXTRACTED_SLOTS_ARE_REUSED) {
+  compact_bst<int, int, Inorder> a{{1, 1}, {2, 1}, {3, 1}};
+  ASSERT_EQ(a.slots(), 3);
+  a.extract(2);
+  a.insert({4, 1});
+  ASSERT_EQ(a.slots(), 3);
+  a.insert({0, 1});
+  ASSERT_EQ(a.slots(), 4);
+  ASSERT_EQ(keys(a), (std::vector<int>{0, 1, 3, 4}));
+}
+
+TEST(COMPACT_BST_OPERATIONS, DUPLICATE_KEEPS_SMALLER_VALUE) {
+  compact_bst<int, int> a{{1, 5}};
+  a.insert({1, 3});
+  a.insert({1, 4});
+  ASSERT_EQ(a.size(), 1);
+  ASSERT_EQ((*a.begin()).second, 3);
+}
+
+TEST(COMPACT_BST_OPERATIONS, CONST_TREE_GIVES_CONST_VALUES) {
+  compact_bst<int, int> a{{1, 5}, {2, 3}};
+  const auto& view = a;
+  static_assert(std::is_same_v<decltype(view.begin().value()), const int&>);
+  static_assert(std::is_same_v<decltype(a.begin().value()), int&>);
+  a.begin().value() = 7;
+  ASSERT_EQ(view.begin().value(), 7);
+}
+
+TEST(COMPACT_BST_OPERATIONS, CLEAR) {
+  compact_bst<int, int> a{{1, 5}, {2, 3}};
+  a.clear();
+  ASSERT_EQ(a.size(), 0);
+  ASSERT_TRUE(a.begin() == a.end());
+}
@@ -0,0 +1,78 @@
+#include <lib/hashed_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <vector>
+
+TEST(HASHED_BST_INIT, INITIALIZER_LIST_CONSTRUCTOR) {
+  hashed_bst<int, int> a{{1, 2}, {3, 4}};
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_TRUE(a.contains(3));
+  ASSERT_FALSE(a.contains(2));
+}
+
+TEST(HASHED_BST_INIT, COPY_CONSTRUCTOR) {
+  hashed_bst<int, int> a{{1, 2}, {3, 4}};
+  hashed_bst<int, int> b = a;
+  a.erase(1);
+  ASSERT_TRUE(b.contains(1));
+  ASSERT_EQ((*b.find(1)).value.second, 2);
+}
+
+TEST(HASHED_BST_OPERATIONS, FIND_AND_DUPLICATES) {
+  hashed_bst<int, int> a{{100, 5}, {20, 1}, {10, 1}};
+  a.insert({100, 3});
+  a.insert({100, 4});
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_EQ((*a.find(100)).value.second, 3);
+  ASSERT_EQ(a.find(42), (hashed_bst<int, int>::iterator()));
+}
+
+TEST(HASHED_BST_OPERATIONS, ORDERED_ITERATION_KEPT) {
+  hashed_bst<int, int, Inorder> a{{100, 1}, {20, 1}, {10, 1}, {200, 1}, {150, 1}, {300, 1}};
+  std::vector<int> keys;
+  auto it = a.begin();
+  for (size_t i = 0; i < a.size(); ++i) {
+    ++it;
+    keys.push_back((*it).value.first);
+  }
+  ASSERT_EQ(keys, (std::vector<int>{10, 20, 100, 150, 200, 300}));
+  ASSERT_TRUE(it == a.end());
+}
+
+TEST(HASHED_BST_OPERATIONS, LOAD_FACTOR_AND_MEMORY) {
+  hashed_bst<int, int> a(0.25f);
+  for (int i = 0; i < 1000; i++) {
+    a.insert({i, i});
+  }
+  ASSERT_LE(a.load_factor(), 0.25f);
+  ASSERT_EQ(a.index_memory(), a.bucket_count() * sizeof(void*));
+  a.max_load_factor(0.9f);
+  ASSERT_LE(a.bucket_count(), 2048);
+  ASSERT_TRUE(a.contains(999));
+}
+
+TEST(HASHED_BST_OPERATIONS, MATCHES_STD_SET_UNDER_CHURN) {
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<int> key(0, 500);
+  std::set<int> expected;
+  hashed_bst<int, int> a;
+  for (int i = 0; i < 5000; i++) {
+    int k = key(gen);
+    if (i % 2) {
+      ASSERT_EQ(a.erase(k), expected.erase(k));
+    } else {
+      a.insert({k, i});
+      expected.insert(k);
+    }
+  }
+  ASSERT_EQ(a.size(), expected.size());
+  for (int k = 0; k <= 500; k++) {
+    ASSERT_EQ(a.contains(k), expected.count(k) == 1);
+  }
+  a.erase_if([](const std::pair<int, int>& value) { return value.first < 250; });
+  ASSERT_FALSE(a.contains(100));
+  ASSERT_EQ(a.contains(400), expected.count(400) == 1);
+}
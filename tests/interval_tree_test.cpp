@@ -0,0 +1,34 @@
+#include <lib/interval_tree.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(INTERVAL_TREE_INIT, INITIALIZER_LIST_CONSTRUCTOR) {
+  interval_tree<int, int> a{{{1, 5}, 1}, {{3, 4}, 2}};
+  ASSERT_EQ(a.size(), 2);
+}
+
+TEST(INTERVAL_TREE_OPERATIONS, OVERLAPPING_POINT) {
+  interval_tree<int, int, Inorder> a{{{15, 20}, 1}, {{10, 30}, 2}, {{17, 19}, 3}, {{5, 20}, 4}, {{12, 15}, 5},
+                                     {{30, 40}, 6}};
+  auto found = a.overlapping(16);
+  ASSERT_EQ(found.size(), 3);
+  EXPECT_EQ((*found[0]).value.second, 4);
+  EXPECT_EQ((*found[1]).value.second, 2);
+  EXPECT_EQ((*found[2]).value.second, 1);
+  ASSERT_TRUE(a.overlapping(41).empty());
+}
+
+TEST(INTERVAL_TREE_OPERATIONS, OVERLAPPING_INTERVAL) {
+  interval_tree<int, int, Inorder> a{{{15, 20}, 1}, {{10, 30}, 2}, {{17, 19}, 3}, {{5, 20}, 4}, {{12, 15}, 5},
+                                     {{30, 40}, 6}};
+  ASSERT_EQ(a.overlapping({21, 30}).size(), 2);
+  ASSERT_EQ(a.overlapping({0, 4}).size(), 0);
+  ASSERT_EQ(a.overlapping({0, 100}).size(), 6);
+}
+
+TEST(INTERVAL_TREE_OPERATIONS, OVERLAPPING_AFTER_EXTRACT) {
+  interval_tree<int, int, Inorder> a{{{15, 20}, 1}, {{10, 30}, 2}, {{17, 19}, 3}, {{5, 20}, 4}};
+  a.extract({10, 30});
+  ASSERT_TRUE(a.overlapping(25).empty());
+  ASSERT_EQ(a.overlapping(18).size(), 3);
+}
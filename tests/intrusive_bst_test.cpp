@@ -0,0 +1,81 @@
+#include <lib/intrusive_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+struct job : bst_hook<job> {
+  int id = 0;
+  int priority = 0;
+};
+
+struct job_id {
+  int operator()(const job& item) const { return item.id; }
+};
+
+TEST(INTRUSIVE_BST, LINKS_USER_OBJECTS) {
+  std::vector<job> pool(6);
+  int ids[] = {100, 20, 10, 200, 150, 300};
+  intrusive_bst<job, job_id> a;
+  for (int i = 0; i < 6; i++) {
+    pool[i].id = ids[i];
+    ASSERT_TRUE(a.insert(pool[i]));
+  }
+  ASSERT_EQ(a.size(), 6);
+  ASSERT_TRUE(a.contains(150));
+  ASSERT_EQ(&*a.find(200), &pool[3]);
+  ASSERT_EQ(&*a.begin(), &pool[0]);
+  ASSERT_EQ(pool[0].left, &pool[1]);
+  ASSERT_EQ(pool[4].parent, &pool[3]);
+}
+
+TEST(INTRUSIVE_BST, DUPLICATE_KEY_IS_REJECTED) {
+  job a_job{{}, 1, 5};
+  job other{{}, 1, 7};
+  intrusive_bst<job, job_id> a;
+  ASSERT_TRUE(a.insert(a_job));
+  ASSERT_FALSE(a.insert(other));
+  ASSERT_EQ(a.size(), 1);
+  ASSERT_EQ(a.find(1)->priority, 5);
+}
+
+TEST(INTRUSIVE_BST, EXTRACT_AND_MOVE_BETWEEN_TREES) {
+  std::vector<job> pool(6);
+  int ids[] = {100, 20, 10, 200, 150, 300};
+  intrusive_bst<job, job_id, Inorder> a;
+  intrusive_bst<job, job_id, Inorder> b;
+  for (int i = 0; i < 6; i++) {
+    pool[i].id = ids[i];
+    a.insert(pool[i]);
+  }
+  job* moved = a.extract(100);
+  ASSERT_EQ(moved, &pool[0]);
+  ASSERT_EQ(moved->left, nullptr);
+  ASSERT_TRUE(b.insert(*moved));
+  a.erase(pool[3]);
+  ASSERT_EQ(a.size(), 4);
+  ASSERT_FALSE(a.contains(100));
+  ASSERT_FALSE(a.contains(200));
+  for (int id : {10, 20, 150, 300}) {
+    ASSERT_TRUE(a.contains(id));
+  }
+  ASSERT_EQ(a.extract(42), nullptr);
+  ASSERT_TRUE(b.contains(100));
+}
+
+TEST(INTRUSIVE_BST, CLEAR_UNLINKS_EVERY_OBJECT) {
+  std::vector<job> pool(1000);
+  {
+    intrusive_bst<job, job_id> a;
+    for (int i = 0; i < 1000; i++) {
+      pool[i].id = i;
+      a.insert(pool[i]);
+    }
+  }
+  for (const job& item : pool) {
+    ASSERT_EQ(item.parent, nullptr);
+    ASSERT_EQ(item.left, nullptr);
+    ASSERT_EQ(item.right, nullptr);
+    ASSERT_FALSE(item.visited);
+  }
+}
@@ -29,6 +29,15 @@ TEST(ITERATOR_BASIC_OPERATORS, EQUALITY_OPERATOR) {
   EXPECT_TRUE(lhs == rhs);
 }
 
+TEST(ITERATOR_BASIC_OPERATORS, EQUALITY_WITH_EMPTY_ITERATOR) {
+  int a = 4;
+  bst_iterator<int> lhs(&a);
+  bst_iterator<int> empty;
+  EXPECT_TRUE(empty == bst_iterator<int>());
+  EXPECT_FALSE(lhs == empty);
+  EXPECT_FALSE(empty == lhs);
+}
+
 TEST(ITERATOR_BASIC_OPERATORS, INEQUALITY_OPERATOR) {
   int a = 4;
   int d = 6;
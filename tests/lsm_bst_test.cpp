@@ -0,0 +1,84 @@
+#include <lib/lsm_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+TEST(LSM_BST, FIND_ACROSS_TIERS) {
+  lsm_bst<int, int> a(4);
+  for (int i = 0; i < 10; i++) {
+    a.insert({i, i * 10});
+  }
+  ASSERT_EQ(a.memtable_size(), 2);
+  ASSERT_GE(a.run_count(), 1);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(a.find(i), i * 10);
+  }
+  ASSERT_FALSE(a.contains(10));
+}
+
+TEST(LSM_BST, NEWEST_WRITE_AND_TOMBSTONES_WIN) {
+  lsm_bst<int, int> a(2);
+  a.insert({{1, 1}, {2, 2}, {3, 3}, {4, 4}});
+  a.insert({1, 10});
+  a.extract(3);
+  ASSERT_EQ(a.find(1), 10);
+  ASSERT_FALSE(a.contains(3));
+  a.flush();
+  a.wait_for_merges();
+  ASSERT_EQ(a.find(1), 10);
+  ASSERT_FALSE(a.contains(3));
+  ASSERT_EQ(a.find(4), 4);
+}
+
+TEST(LSM_BST, SCAN_IN_KEY_ORDER) {
+  lsm_bst<int, int> a(3);
+  a.insert({{5, 5}, {1, 1}, {9, 9}, {3, 3}, {7, 7}, {2, 2}, {8, 8}});
+  a.extract(7);
+  a.insert({3, 30});
+  std::vector<std::pair<int, int>> seen;
+  a.scan(2, 8, [&seen](int key, int value) { seen.emplace_back(key, value); });
+  std::vector<std::pair<int, int>> expected{{2, 2}, {3, 30}, {5, 5}, {8, 8}};
+  ASSERT_EQ(seen, expected);
+}
+
+TEST(LSM_BST, MERGES_KEEP_RUNS_LOGARITHMIC) {
+  lsm_bst<int, int> a(64);
+  for (int i = 0; i < 64 * 256; i++) {
+    a.insert({i, i});
+  }
+  a.wait_for_merges();
+  ASSERT_LE(a.run_count(), 10);
+  int count = 0;
+  a.scan(0, 64 * 256, [&count](int key, int value) { count += key == value; });
+  ASSERT_EQ(count, 64 * 256);
+}
+
+TEST(LSM_BST, MATCHES_STD_MAP_UNDER_CHURN) {
+  lsm_bst<int, int> a(32, 4);
+  std::map<int, int> expected;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> keys(0, 500);
+  for (int step = 0; step < 20000; step++) {
+    int key = keys(gen);
+    if (step % 4 == 0) {
+      a.extract(key);
+      expected.erase(key);
+    } else {
+      a.insert({key, step});
+      expected[key] = step;
+    }
+    if (step % 1000 == 0) {
+      int probe = keys(gen);
+      auto found = expected.find(probe);
+      ASSERT_EQ(a.find(probe), found == expected.end() ? std::nullopt : std::optional<int>(found->second));
+    }
+  }
+  a.wait_for_merges();
+  std::map<int, int> scanned;
+  a.scan(0, 500, [&scanned](int key, int value) { scanned[key] = value; });
+  ASSERT_EQ(scanned, expected);
+  a.clear();
+  ASSERT_FALSE(a.contains(expected.begin()->first));
+}
@@ -0,0 +1,67 @@
+#include <lib/static_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string_view>
+#include <vector>
+
+constexpr auto opcodes = make_static_bst<std::string_view, int, Inorder>({
+    {"mov", 1}, {"add", 2}, {"sub", 3}, {"jmp", 4}, {"cmp", 5}, {"ret", 6}, {"nop", 7}});
+
+static_assert(opcodes.size() == 7);
+static_assert(opcodes.contains("jmp"));
+static_assert(!opcodes.contains("xor"));
+static_assert(opcodes.find("ret")->second == 6);
+static_assert(opcodes.lower_bound("n")->first == "nop");
+static_assert(opcodes.lower_bound("z") == opcodes.end());
+
+template<class Tree>
+std::vector<int> keys_of(const Tree& tree) {
+  std::vector<int> keys;
+  for (const auto& [key, value] : tree) {
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+TEST(STATIC_BST, INORDER_IS_SORTED) {
+  std::vector<std::string_view> keys;
+  for (const auto& item : opcodes) {
+    keys.push_back(item.first);
+  }
+  std::vector<std::string_view> expected{"add", "cmp", "jmp", "mov", "nop", "ret", "sub"};
+  ASSERT_EQ(keys, expected);
+}
+
+TEST(STATIC_BST, PREORDER_AND_POSTORDER) {
+  // 6 elements fill the slots as   4
+  //                              2   6
+  //                             1 3 5
+  constexpr auto pre = make_static_bst<int, int, Preorder>({{1, 0}, {2, 0}, {3, 0}, {4, 0}, {5, 0}, {6, 0}});
+  constexpr auto post = make_static_bst<int, int, Postorder>({{6, 0}, {5, 0}, {4, 0}, {3, 0}, {2, 0}, {1, 0}});
+  ASSERT_EQ(keys_of(pre), (std::vector<int>{4, 2, 1, 3, 6, 5}));
+  ASSERT_EQ(keys_of(post), (std::vector<int>{1, 3, 2, 5, 6, 4}));
+}
+
+TEST(STATIC_BST, LOOKUPS_MATCH_LINEAR_SEARCH) {
+  constexpr auto squares = make_static_bst<int, int>({
+      {0, 0}, {3, 9}, {6, 36}, {9, 81}, {12, 144}, {15, 225}, {18, 324}, {21, 441}, {24, 576}, {27, 729}});
+  for (int key = -1; key < 30; key++) {
+    ASSERT_EQ(squares.contains(key), key % 3 == 0 && key >= 0 && key < 30);
+    auto bound = squares.lower_bound(key);
+    int expected = key <= 0 ? 0 : (key + 2) / 3 * 3;
+    if (expected >= 30) {
+      ASSERT_EQ(bound, squares.end());
+    } else {
+      ASSERT_EQ(bound->first, expected);
+      ASSERT_EQ(bound->second, expected * expected);
+    }
+  }
+}
+
+TEST(STATIC_BST, SINGLE_ELEMENT) {
+  constexpr auto one = make_static_bst<int, char, Postorder>({{42, 'x'}});
+  ASSERT_EQ(keys_of(one), std::vector<int>{42});
+  ASSERT_EQ(one.find(42)->second, 'x');
+  ASSERT_EQ(one.find(7), one.end());
+}
@@ -0,0 +1,91 @@
+#include <lib/allocator/tracking_allocator.hpp>
+#include <lib/string_bst.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+template<class Tree>
+std::vector<std::string> keys(const Tree& tree) {
+  std::vector<std::string> result;
+  for (auto it = tree.begin(); it != tree.end(); ++it) {
+    result.push_back(it.key());
+  }
+  return result;
+}
+
+TEST(STRING_BST_INIT, INITIALIZER_LIST_CONSTRUCTOR) {
+  string_bst<int> a{{"foo", 1}, {"bar", 1}, {"baz", 1}};
+  ASSERT_EQ(a.size(), 3);
+  ASSERT_TRUE(a.contains("baz"));
+  ASSERT_FALSE(a.contains("ba"));
+}
+
+TEST(STRING_BST_INIT, COPY_CONSTRUCTOR) {
+  string_bst<int, Inorder> a{{"foo", 1}, {"bar", 1}, {"baz", 1}};
+  string_bst<int, Inorder> b = a;
+  a.extract("bar");
+  ASSERT_EQ(keys(b), (std::vector<std::string>{"bar", "baz", "foo"}));
+}
+
+TEST(STRING_BST_INIT, COPIES_FREE_WITH_THEIR_OWN_ALLOCATOR) {
+  using tracked = string_bst<int, Preorder, tracking_allocator<std::pair<std::string, int>>>;
+  tracked a{{"alpha", 1}, {"beta", 2}};
+  tracked b(a);
+  ASSERT_FALSE(a.allocator_ == b.allocator_);
+  ASSERT_EQ(b.allocator_.stats().live_allocations(), 2);
+
+  tracked c{{"gamma", 3}};
+  auto replaced = c.allocator_;
+  c = a;
+  ASSERT_EQ(replaced.stats().live_allocations(), 0);
+  ASSERT_EQ(c.allocator_.stats().live_allocations(), 2);
+  ASSERT_EQ(a.allocator_.stats().live_allocations(), 2);
+}
+
+TEST(STRING_BST_OPERATIONS, TRAVERSAL_ORDERS) {
+  std::initializer_list<std::pair<std::string, int>> values{
+      {"/usr/local", 1}, {"/usr/bin", 1}, {"/usr", 1}, {"/usr/share", 1}, {"/usr/lib", 1}, {"/var", 1}};
+  ASSERT_EQ(keys(string_bst<int, Preorder>(values)),
+            (std::vector<std::string>{"/usr/local", "/usr/bin", "/usr", "/usr/lib", "/usr/share", "/var"}));
+  ASSERT_EQ(keys(string_bst<int, Inorder>(values)),
+            (std::vector<std::string>{"/usr", "/usr/bin", "/usr/lib", "/usr/local", "/usr/share", "/var"}));
+  ASSERT_EQ(keys(string_bst<int, Postorder>(values)),
+            (std::vector<std::string>{"/usr", "/usr/lib", "/usr/bin", "/var", "/usr/share", "/usr/local"}));
+}
+
+TEST(STRING_BST_OPERATIONS, PREFIXES_AND_EMPTY_KEY) {
+  string_bst<int, Inorder> a{{"abc", 1}, {"ab", 2}, {"abcd", 3}, {"", 4}, {"a", 5}};
+  ASSERT_EQ(keys(a), (std::vector<std::string>{"", "a", "ab", "abc", "abcd"}));
+  ASSERT_TRUE(a.contains(""));
+  ASSERT_FALSE(a.contains("abd"));
+  a.insert({"ab", 1});
+  ASSERT_EQ(a.size(), 5);
+}
+
+TEST(STRING_BST_OPERATIONS, MATCHES_STD_SET_UNDER_CHURN) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> length(0, 6);
+  std::uniform_int_distribution<int> letter('a', 'c');
+  std::set<std::string> expected;
+  string_bst<int, Inorder> a;
+  for (int i = 0; i < 2000; i++) {
+    std::string key = "https://example.com/";
+    for (int j = length(gen); j > 0; j--) key += static_cast<char>(letter(gen));
+    if (i % 3 == 0) {
+      expected.erase(key);
+      a.extract(key);
+    } else {
+      expected.insert(key);
+      a.insert({key, i});
+    }
+  }
+  ASSERT_EQ(a.size(), expected.size());
+  ASSERT_EQ(keys(a), std::vector<std::string>(expected.begin(), expected.end()));
+  for (const auto& key : expected) {
+    ASSERT_TRUE(a.contains(key));
+  }
+}
@@ -0,0 +1,66 @@
+#include <lib/allocator/tracking_allocator.hpp>
+#include <lib/bst.hpp>
+
+#include <gtest/gtest.h>
+
+using tracked_bst = bst<int, int, Inorder, std::less<int>, tracking_allocator<std::pair<int, int>>>;
+
+const size_t node_size = sizeof(tracked_bst::allocator_type::value_type);
+
+TEST(TRACKING_ALLOCATOR, COUNTS_LIVE_AND_PEAK_BYTES) {
+  tracked_bst a{{100, 1}, {20, 1}, {10, 1}, {200, 1}};
+  const allocation_stats& stats = a.get_allocator().stats();
+  ASSERT_EQ(stats.live_bytes, 4 * node_size);
+  ASSERT_EQ(stats.allocations, 4);
+  a.extract(20);
+  a.extract(10);
+  ASSERT_EQ(stats.live_bytes, 2 * node_size);
+  ASSERT_EQ(a.memory_usage().node_bytes, stats.live_bytes);
+  ASSERT_EQ(stats.peak_bytes, 4 * node_size);
+  ASSERT_EQ(stats.live_allocations(), 2);
+  a.clear();
+  ASSERT_EQ(stats.live_bytes, 0);
+  ASSERT_EQ(stats.deallocations, 4);
+}
+
+TEST(TRACKING_ALLOCATOR, COPY_GETS_ITS_OWN_COUNTERS) {
+  tracked_bst a{{100, 1}, {20, 1}, {10, 1}};
+  tracked_bst b = a;
+  b.insert({1, 1});
+  ASSERT_EQ(a.get_allocator().stats().live_bytes, 3 * node_size);
+  ASSERT_EQ(b.get_allocator().stats().live_bytes, 4 * node_size);
+  ASSERT_FALSE(a.get_allocator() == b.get_allocator());
+}
+
+TEST(TRACKING_ALLOCATOR, SEES_COMPACT_AND_ASYNC_CLEAR) {
+  tracked_bst a;
+  for (int i = 0; i < 100; i++) {
+    a.insert({(i * 37) % 100, i});
+  }
+  auto allocator = a.get_allocator();
+  a.compact();
+  ASSERT_EQ(allocator.stats().live_allocations(), 1);
+  ASSERT_EQ(allocator.stats().live_bytes, 100 * node_size);
+  ASSERT_EQ(allocator.stats().peak_bytes, 200 * node_size);
+  ASSERT_EQ(a.clear_async().get(), 100);
+  ASSERT_EQ(allocator.stats().live_bytes, 0);
+}
+
+TEST(TRACKING_ALLOCATOR, SPLICING_REQUIRES_EQUAL_ALLOCATORS) {
+  tracked_bst a{{1, 1}, {2, 2}};
+  tracked_bst b{{5, 5}, {6, 6}};
+  ASSERT_THROW(tracked_bst::join(std::move(a), std::move(b)), std::invalid_argument);
+
+  auto handle = b.extract(5);
+  ASSERT_THROW(a.insert(std::move(handle)), std::invalid_argument);
+  ASSERT_FALSE(handle.empty());
+  ASSERT_EQ(a.size(), 2);
+  ASSERT_EQ(a.get_allocator().stats().live_bytes, 2 * node_size);
+  ASSERT_EQ(b.get_allocator().stats().live_bytes, 2 * node_size);
+
+  // split hands its allocator to the new tree, so the halves join back
+  auto right = a.split(2);
+  auto whole = tracked_bst::join(std::move(a), std::move(right));
+  ASSERT_EQ(whole.size(), 2);
+  ASSERT_EQ(whole.get_allocator().stats().live_bytes, 2 * node_size);
+}